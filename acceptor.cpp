@@ -0,0 +1,99 @@
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+
+#include "acceptor.h"
+#include "worker.h"
+
+Acceptor::Acceptor(const ServerConfig& config)
+    : config(config), listenFd(-1), lobbyWorker(nullptr), nextWorker(0), matchCount(0) {}
+
+Acceptor::~Acceptor(){
+    if(listenFd >= 0){
+        reactor.remove(listenFd);
+        close(listenFd);
+    }
+}
+
+// Creates, binds and registers a non-blocking listening socket on port
+bool Acceptor::listen(int port){
+    struct sockaddr_in address;
+
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(listenFd < 0){
+        perror("socket failed");
+        return false;
+    }
+
+    int opt = 1;
+    if(setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0){
+        perror("setsockopt failed");
+        return false;
+    }
+
+    // Initializes the server address structure with IPv4, any incoming IP, and the specified port
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+
+    if(bind(listenFd, (struct sockaddr *)&address, sizeof(address)) < 0){
+        perror("bind failed");
+        return false;
+    }
+
+    if(::listen(listenFd, config.listenBacklog) < 0){
+        perror("listen failed");
+        return false;
+    }
+
+    reactor.add(listenFd, EPOLLIN, [this](uint32_t){ onAccept(); });
+    return true;
+}
+
+void Acceptor::run(std::vector<Worker *> workers){
+    this->workers = std::move(workers);
+    openLobby();
+    reactor.run();
+}
+
+// Asks the next worker in turn to open the lobby that receives the next players
+void Acceptor::openLobby(){
+    lobbyWorker = workers[nextWorker];
+    nextWorker = (nextWorker + 1) % workers.size();
+    lobbyWorker->hostLobby(++matchCount);
+}
+
+// Accepts pending connections and hands them to the open lobby in one batch. A burst stops after
+// acceptBurst; the socket stays readable and the rest are taken on the next wakeup.
+void Acceptor::onAccept(){
+    std::vector<int> socks;
+    for(int accepted = 0; accepted < config.acceptBurst; accepted++){
+        int newSock = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(newSock < 0){
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) perror("accept failed");
+            break;
+        }
+        socks.push_back(newSock);
+    }
+
+    if(!socks.empty()) dispatch(std::move(socks));
+}
+
+void Acceptor::dispatch(std::vector<int> socks){
+    lobbyWorker->takeClients(std::move(socks));
+}
+
+// A worker reports each lobby once, so only the current one opens the next. Its next lobby is
+// queued on the next worker before any socket it returns afterwards.
+void Acceptor::lobbyClosed(Worker *worker){
+    reactor.post([this, worker](){
+        if(worker == lobbyWorker) openLobby();
+    });
+}
+
+void Acceptor::returnClients(std::vector<int> socks){
+    reactor.post([this, socks = std::move(socks)]() mutable { dispatch(std::move(socks)); });
+}
@@ -0,0 +1,48 @@
+#ifndef ACCEPTOR_H
+#define ACCEPTOR_H
+
+#include <vector>
+
+#include "reactor.h"
+#include "serverconfig.h"
+
+class Worker;
+
+// Accepts every player on one listening socket and fills one lobby at a time, so players who
+// join together end up in the same match however many workers there are. Each lobby is hosted by
+// the worker that will run its match, picked in turn, and the acceptor only hands it sockets:
+// matches are spread across workers, connections are not.
+class Acceptor {
+    private:
+        const ServerConfig& config;
+        Reactor reactor;
+        int listenFd;
+        std::vector<Worker *> workers;
+        Worker *lobbyWorker; // Hosts the open lobby
+        size_t nextWorker;   // Next in turn to host a lobby
+        int matchCount;      // Matches opened so far, used as match ids
+
+        void openLobby();
+        void onAccept();
+        void dispatch(std::vector<int> socks);
+
+    public:
+        explicit Acceptor(const ServerConfig& config);
+        ~Acceptor();
+
+        Acceptor(const Acceptor&) = delete;
+        Acceptor& operator=(const Acceptor&) = delete;
+
+        // Creates the listening socket
+        bool listen(int port);
+
+        // Opens the first lobby and accepts players on the calling thread until the process ends
+        void run(std::vector<Worker *> workers);
+
+        // Called from worker threads: the worker's lobby started its match, or it no longer had a
+        // lobby to put these sockets in
+        void lobbyClosed(Worker *worker);
+        void returnClients(std::vector<int> socks);
+};
+
+#endif
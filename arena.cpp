@@ -0,0 +1,30 @@
+#include "arena.h"
+#include "constants.h"
+#include "metrics.h"
+
+void* MatchArena::Chunks::do_allocate(size_t bytes, size_t alignment){
+    void *p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    held += bytes;
+    metrics.arenaChunks.add();
+    metrics.arenaBytes.add(bytes);
+    return p;
+}
+
+void MatchArena::Chunks::do_deallocate(void *p, size_t bytes, size_t alignment){
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    held -= bytes;
+    metrics.arenaBytes.sub(bytes);
+}
+
+// The pool's own chunks come from the monotonic arena, so releasing both gives everything back
+MatchArena::MatchArena(WorkerMetrics& metrics)
+    : heap(metrics), chunks(ARENA_FIRST_CHUNK, &heap), pool(std::pmr::pool_options{0, ARENA_MAX_BLOCK}, &chunks) {}
+
+bool MatchArena::fits(size_t bytes){
+    return bytes <= ARENA_MAX_BLOCK;
+}
+
+void MatchArena::release(){
+    pool.release();
+    chunks.release();
+}
@@ -0,0 +1,54 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+
+struct WorkerMetrics;
+
+// Memory a match allocates from while it runs: the frames it sends and its send queues' nodes.
+// A monotonic arena takes chunks from the heap as the match grows, and a pool on top recycles the
+// blocks each turn frees, so a battle that has warmed up plays its turns without heap calls.
+// Nothing goes back to the heap until release, which frees every chunk in one shot.
+// Single-threaded, like the match that owns it.
+class MatchArena {
+    private:
+        // Hands out the arena's chunks and counts them in the worker's metrics
+        class Chunks : public std::pmr::memory_resource {
+            private:
+                WorkerMetrics& metrics;
+                size_t held; // Bytes currently taken from the heap
+
+                void* do_allocate(size_t bytes, size_t alignment) override;
+                void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+                bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+            public:
+                explicit Chunks(WorkerMetrics& metrics) : metrics(metrics), held(0) {}
+                size_t heldBytes() const { return held; }
+        };
+
+        Chunks heap;
+        std::pmr::monotonic_buffer_resource chunks;
+        std::pmr::unsynchronized_pool_resource pool;
+
+    public:
+        explicit MatchArena(WorkerMetrics& metrics);
+        ~MatchArena() { release(); }
+
+        MatchArena(const MatchArena&) = delete;
+        MatchArena& operator=(const MatchArena&) = delete;
+
+        std::pmr::memory_resource* resource() { return &pool; }
+
+        // Whether a block of this size is recycled by the pool. Larger ones would stay in the
+        // arena until release, so they belong on the heap.
+        static bool fits(size_t bytes);
+
+        // Returns every chunk to the heap. Nothing allocated from the arena may be in use.
+        void release();
+
+        size_t heldBytes() const { return heap.heldBytes(); }
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "battleframes.h"
+#include "protocol.h"
+#include "characters/actiontext.h"
+
+// Wire state of a player. name and className must outlive the returned views.
+static PlayerState stateOf(uint32_t index, Character *c, const std::string& name, const std::string& className){
+    PlayerState state;
+    state.index = index;
+    state.name = name;
+    state.className = className;
+    state.health = c->getHealth();
+    state.mana = c->getMana();
+    state.flags = (c->isAlive() ? PLAYER_ALIVE : 0) | (c->getNextAttackProtected() ? PLAYER_PROTECTED : 0);
+    state.attackBonus = c->getAttackBonus();
+    return state;
+}
+
+void takeChanges(const std::vector<Character *>& players, std::vector<PlayerChange>& changes){
+    changes.clear();
+    for(size_t i = 0; i < players.size(); ++i){
+        uint8_t dirty = players[i]->takeDirty();
+        if(dirty == 0) continue;
+
+        uint8_t fields = 0;
+        if(dirty & DIRTY_HEALTH) fields |= FIELD_HEALTH;
+        if(dirty & DIRTY_MANA) fields |= FIELD_MANA;
+        if(dirty & DIRTY_STATUS) fields |= FIELD_FLAGS;
+        if(dirty & DIRTY_BONUS) fields |= FIELD_BONUS;
+        changes.push_back(PlayerChange{(uint32_t)i, fields});
+    }
+}
+
+void encodeSnapshot(std::string& out, uint32_t seq, uint32_t self, const std::vector<Character *>& players){
+    FrameWriter w(out, MSG_SNAPSHOT);
+    encodeSnapshotHeader(w, seq, self, (uint32_t)players.size());
+    for(size_t i = 0; i < players.size(); ++i){
+        std::string className = players[i]->getClass();
+        encodeSnapshotEntry(w, stateOf((uint32_t)i, players[i], players[i]->getName(), className));
+    }
+}
+
+void encodeDelta(std::string& out, uint32_t seq, const std::vector<Character *>& players,
+                 const std::vector<PlayerChange>& changes){
+    static const std::string unused;
+
+    FrameWriter w(out, MSG_DELTA);
+    encodeDeltaHeader(w, seq, (uint32_t)changes.size());
+    for(const PlayerChange& change : changes){
+        encodeDeltaEntry(w, change.fields, stateOf(change.index, players[change.index], unused, unused));
+    }
+}
+
+void encodeTurnResult(std::string& out, std::string& text, const std::vector<Character *>& players,
+                      int attacker, int action, int target, const ActionResult& result){
+    static const std::string nobody;
+    const std::string& attackerName = players[attacker]->getName();
+    const std::string& targetName = target >= 0 ? players[target]->getName() : nobody;
+
+    text.clear();
+    if(result.isError()){
+        text += "Error: ";
+        appendActionText(text, attackerName, targetName, result);
+        text += "\n";
+    }
+    else if(target < 0){
+        appendActionText(text, attackerName, targetName, result);
+    }
+    else{
+        text += attackerName;
+        text += " used action on ";
+        text += targetName;
+        text += ". ";
+        appendActionText(text, attackerName, targetName, result);
+    }
+
+    ActionResultMessage msg;
+    msg.attacker = (uint32_t)attacker;
+    msg.target = target >= 0 ? (uint32_t)target : NO_PLAYER;
+    msg.action = (uint8_t)action;
+    msg.flags = (result.isError() ? RESULT_ERROR : 0) | (target < 0 ? RESULT_AREA : 0);
+    msg.damage = result.damage;
+    msg.heal = result.heal;
+    msg.text = text;
+
+    encodeActionResult(out, msg);
+}
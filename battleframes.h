@@ -0,0 +1,36 @@
+#ifndef BATTLEFRAMES_H
+#define BATTLEFRAMES_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "characters/character.h"
+
+// Builders for the battle frames the server sends every turn. They only read the roster and
+// append to out, so the match can broadcast the bytes and the bench can time them in isolation.
+// Player numbers are positions in players, the turn order.
+
+// A player whose state changed, and which PlayerField values changed
+struct PlayerChange {
+    uint32_t index;
+    uint8_t fields;
+};
+
+// Collects and clears the dirty fields of every player
+void takeChanges(const std::vector<Character *>& players, std::vector<PlayerChange>& changes);
+
+// MSG_SNAPSHOT frame with every player's full state; self is the recipient's player number
+void encodeSnapshot(std::string& out, uint32_t seq, uint32_t self, const std::vector<Character *>& players);
+
+// MSG_DELTA frame with only the changed fields of the changed players
+void encodeDelta(std::string& out, uint32_t seq, const std::vector<Character *>& players,
+                 const std::vector<PlayerChange>& changes);
+
+// MSG_ACTION_RESULT frame for attacker's action on target, or -1 for an area action, whose
+// victims are summed up in one frame. The narration is formatted into text, a scratch buffer the
+// caller keeps between turns.
+void encodeTurnResult(std::string& out, std::string& text, const std::vector<Character *>& players,
+                      int attacker, int action, int target, const ActionResult& result);
+
+#endif
@@ -0,0 +1,465 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "battleframes.h"
+#include "controller.h"
+#include "protocol.h"
+#include "characters/factory.h"
+
+// Microbenchmarks for the game rules and the per-turn frame builders. Each benchmark is calibrated
+// so one sample takes about --sample-ms, then timed --samples times; the report gives the spread
+// of nanoseconds per operation. --json saves the results and --baseline compares against a saved
+// run, failing when a median got slower than --threshold percent.
+
+#define FIXTURE_BATCH 256 // Fresh characters per untimed setup, so mana and health never run out
+#define NOVA_BATCH 6      // Novas per fresh roster: six rounds of 10 damage leave every 65 health Mage standing
+#define BUFFED_PASSES 2   // Special-move passes per fresh roster: the buffing pass and two more deal 75 to a 90 health Orc
+
+// A benchmark runs `iterations` operations and returns how many nanoseconds they took, which
+// keeps untimed setup out of the measurement
+struct Benchmark {
+    std::string name;
+    std::function<double(uint64_t iterations)> run;
+};
+
+struct Summary {
+    std::string name;
+    uint64_t iterations = 0; // Per sample
+    double median = 0, mean = 0, stddev = 0, min = 0, max = 0; // Nanoseconds per operation
+};
+
+struct BenchConfig {
+    int samples = 20;
+    int sampleMs = 10;
+    std::string filter;
+    std::string jsonPath;
+    std::string baselinePath;
+    double threshold = 10; // Percent
+};
+
+// Keeps the compiler from discarding a result that is never used
+template <typename T>
+static void doNotOptimize(const T& value){
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedNs(Clock::time_point start){
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+static const char* ACTION_NAMES[] = {"attack", "castSpell", "specialMove"};
+
+// Characters by value in one block, with pointers to them for the Controller and frame builders.
+// Moving a Roster moves the block itself, so the pointers stay valid.
+struct Roster {
+    std::vector<AnyCharacter> owned;
+    std::vector<Character *> players;
+};
+
+static Roster makeRoster(ClassId classId, size_t count){
+    Roster roster;
+    roster.owned.reserve(count);
+    roster.players.reserve(count);
+    for(size_t i = 0; i < count; i++){
+        roster.players.push_back(&emplaceCharacter(roster.owned, classId, "P" + std::to_string(i)));
+    }
+    return roster;
+}
+
+// One Character override called directly, on a fresh character each time
+static double benchCharacterAction(ClassId classId, int action, uint64_t iterations){
+    Rng rng(1);
+    double total = 0;
+
+    for(uint64_t done = 0; done < iterations; done += FIXTURE_BATCH){
+        size_t batch = (size_t)std::min<uint64_t>(FIXTURE_BATCH, iterations - done);
+        Roster attackers = makeRoster(classId, batch);
+
+        auto start = Clock::now();
+        for(size_t i = 0; i < batch; i++){
+            Character *c = attackers.players[i];
+            ActionResult result = action == ATTACK ? c->attack(rng)
+                                : action == CAST_SPELL ? c->castSpell(rng) : c->specialMove(rng);
+            doNotOptimize(result);
+        }
+        total += elapsedNs(start);
+    }
+    return total;
+}
+
+// Controller::applyAction between fresh pairs of the same class
+static double benchApplyAction(ClassId classId, int action, uint64_t iterations){
+    double total = 0;
+
+    for(uint64_t done = 0; done < iterations; done += FIXTURE_BATCH){
+        size_t batch = (size_t)std::min<uint64_t>(FIXTURE_BATCH, iterations - done);
+        Roster attackers = makeRoster(classId, batch);
+        Roster targets = makeRoster(classId, batch);
+        std::vector<Character *> players = attackers.players;
+        players.insert(players.end(), targets.players.begin(), targets.players.end());
+        Controller controller(players, done + 1);
+
+        auto start = Clock::now();
+        for(size_t i = 0; i < batch; i++){
+            ActionResult result = controller.applyAction(attackers.players[i], action, targets.players[i]);
+            doNotOptimize(result);
+        }
+        total += elapsedNs(start);
+    }
+    return total;
+}
+
+// Orc special moves across a roster where every player already carries an attack bonus, so the
+// cost of granting and expiring effects shows up as the number of overlapping buffs grows
+static double benchBuffedRoster(size_t rosterSize, uint64_t iterations){
+    double total = 0;
+
+    // The roster and its buffs are rebuilt untimed for every batch, so no target dies mid-sample
+    uint64_t perRoster = BUFFED_PASSES * rosterSize;
+    for(uint64_t done = 0; done < iterations; done += perRoster){
+        size_t batch = (size_t)std::min<uint64_t>(perRoster, iterations - done);
+        Roster roster = makeRoster(CLASS_ORC, rosterSize);
+        const auto& players = roster.players;
+        Controller controller(players, done + 1);
+        for(size_t i = 0; i < rosterSize; i++) controller.applyAction(players[i], SPECIAL_MOVE, players[(i + 1) % rosterSize]);
+
+        auto start = Clock::now();
+        for(size_t i = 0; i < batch; i++){
+            size_t attacker = i % rosterSize;
+            ActionResult result = controller.applyAction(players[attacker], SPECIAL_MOVE, players[(attacker + 1) % rosterSize]);
+            doNotOptimize(result);
+        }
+        total += elapsedNs(start);
+    }
+    return total;
+}
+
+// Arcane Nova across a roster of Mages, each hitting every other player, so the cost covers the
+// pass over the roster and bringing every victim up to date
+static double benchAreaNova(size_t rosterSize, uint64_t iterations){
+    double total = 0;
+
+    // Every Mage has the mana for two novas
+    uint64_t perRoster = std::min<uint64_t>(NOVA_BATCH, 2 * rosterSize);
+    for(uint64_t done = 0; done < iterations; done += perRoster){
+        size_t batch = (size_t)std::min<uint64_t>(perRoster, iterations - done);
+        Roster roster = makeRoster(CLASS_MAGE, rosterSize);
+        const auto& players = roster.players;
+        Controller controller(players, done + 1);
+
+        auto start = Clock::now();
+        for(size_t i = 0; i < batch; i++){
+            ActionResult result = controller.applyAction(players[i % rosterSize], AREA_ATTACK, nullptr);
+            doNotOptimize(result);
+        }
+        total += elapsedNs(start);
+    }
+    return total;
+}
+
+// Orc Cleave on a roster at full health, which leaves nobody in reach: only the pass itself
+static double benchAreaCleave(size_t rosterSize, uint64_t iterations){
+    Roster roster = makeRoster(CLASS_ORC, rosterSize);
+    const auto& players = roster.players;
+    Controller controller(players, 1);
+
+    auto start = Clock::now();
+    for(uint64_t i = 0; i < iterations; i++){
+        ActionResult result = controller.applyAction(players[i % rosterSize], AREA_ATTACK, nullptr);
+        doNotOptimize(result);
+    }
+    return elapsedNs(start);
+}
+
+// isBattleOver on a roster where everyone is alive; reads the alive counter whatever the size
+static double benchBattleOver(size_t rosterSize, uint64_t iterations){
+    Roster roster = makeRoster(CLASS_ORC, rosterSize);
+    Controller controller(roster.players, 1);
+
+    auto start = Clock::now();
+    for(uint64_t i = 0; i < iterations; i++){
+        bool over = controller.isBattleOver();
+        doNotOptimize(over);
+    }
+    return elapsedNs(start);
+}
+
+// nextTurn late in a battle, when only one player in ten is still alive
+static double benchNextTurn(size_t rosterSize, uint64_t iterations){
+    Roster roster = makeRoster(CLASS_ORC, rosterSize);
+    for(size_t i = 0; i < rosterSize; i++){
+        if(i % 10 != 0) roster.players[i]->setDead();
+    }
+    Controller controller(roster.players, 1);
+
+    auto start = Clock::now();
+    for(uint64_t i = 0; i < iterations; i++){
+        controller.nextTurn();
+        doNotOptimize(controller);
+    }
+    return elapsedNs(start);
+}
+
+// Roster with the three classes interleaved, a third of it dead
+static Roster mixedRoster(size_t rosterSize){
+    Roster roster;
+    roster.owned.reserve(rosterSize);
+    roster.players.reserve(rosterSize);
+    for(size_t i = 0; i < rosterSize; i++){
+        Character& c = emplaceCharacter(roster.owned, (ClassId)(i % CLASS_COUNT), "Player" + std::to_string(i));
+        if(i % 3 == 2) c.setDead();
+        roster.players.push_back(&c);
+    }
+    return roster;
+}
+
+static double benchSnapshot(size_t rosterSize, uint64_t iterations){
+    Roster roster = mixedRoster(rosterSize);
+    const auto& players = roster.players;
+
+    auto start = Clock::now();
+    for(uint64_t i = 0; i < iterations; i++){
+        std::string frame;
+        encodeSnapshot(frame, 1, 0, players);
+        doNotOptimize(frame);
+    }
+    return elapsedNs(start);
+}
+
+// The per-turn update: an attacker's mana and a target's health changed
+static double benchDelta(size_t rosterSize, uint64_t iterations){
+    Roster roster = mixedRoster(rosterSize);
+    const auto& players = roster.players;
+    std::vector<PlayerChange> changes = {{0, FIELD_MANA}, {1, (uint8_t)(FIELD_HEALTH | FIELD_FLAGS)}};
+
+    auto start = Clock::now();
+    for(uint64_t i = 0; i < iterations; i++){
+        std::string frame;
+        encodeDelta(frame, (uint32_t)i, players, changes);
+        doNotOptimize(frame);
+    }
+    return elapsedNs(start);
+}
+
+static double benchTurnResult(uint64_t iterations){
+    Roster roster = mixedRoster(6);
+    const auto& players = roster.players;
+    Rng rng(1);
+    ActionResult result = players[0]->attack(rng);
+    std::string text;
+
+    auto start = Clock::now();
+    for(uint64_t i = 0; i < iterations; i++){
+        std::string frame;
+        encodeTurnResult(frame, text, players, 0, ATTACK, 1, result);
+        doNotOptimize(frame);
+    }
+    return elapsedNs(start);
+}
+
+static std::vector<Benchmark> registerBenchmarks(){
+    std::vector<Benchmark> benchmarks;
+
+    for(int c = 0; c < CLASS_COUNT; c++){
+        for(int a = ATTACK; a <= SPECIAL_MOVE; a++){
+            ClassId classId = (ClassId)c;
+            benchmarks.push_back({std::string("character/") + className(classId) + "/" + ACTION_NAMES[a],
+                                  [classId, a](uint64_t n){ return benchCharacterAction(classId, a, n); }});
+        }
+    }
+    for(int c = 0; c < CLASS_COUNT; c++){
+        for(int a = ATTACK; a <= SPECIAL_MOVE; a++){
+            ClassId classId = (ClassId)c;
+            benchmarks.push_back({std::string("applyAction/") + className(classId) + "/" + ACTION_NAMES[a],
+                                  [classId, a](uint64_t n){ return benchApplyAction(classId, a, n); }});
+        }
+    }
+    for(size_t size : {2, 8, 64, 512, 4096}){
+        benchmarks.push_back({"isBattleOver/n=" + std::to_string(size),
+                              [size](uint64_t n){ return benchBattleOver(size, n); }});
+        benchmarks.push_back({"nextTurn/n=" + std::to_string(size),
+                              [size](uint64_t n){ return benchNextTurn(size, n); }});
+        benchmarks.push_back({"buffedRoster/n=" + std::to_string(size),
+                              [size](uint64_t n){ return benchBuffedRoster(size, n); }});
+        benchmarks.push_back({"areaNova/n=" + std::to_string(size),
+                              [size](uint64_t n){ return benchAreaNova(size, n); }});
+        benchmarks.push_back({"areaCleave/n=" + std::to_string(size),
+                              [size](uint64_t n){ return benchAreaCleave(size, n); }});
+    }
+    for(size_t size : {6, 64, 512}){
+        benchmarks.push_back({"encodeSnapshot/n=" + std::to_string(size),
+                              [size](uint64_t n){ return benchSnapshot(size, n); }});
+        benchmarks.push_back({"encodeDelta/n=" + std::to_string(size),
+                              [size](uint64_t n){ return benchDelta(size, n); }});
+    }
+    benchmarks.push_back({"encodeTurnResult", [](uint64_t n){ return benchTurnResult(n); }});
+
+    return benchmarks;
+}
+
+// Finds the iteration count that makes one sample last about sampleMs
+static uint64_t calibrate(const Benchmark& bench, int sampleMs){
+    double target = sampleMs * 1e6;
+    uint64_t iterations = 1;
+
+    while(true){
+        double ns = bench.run(iterations);
+        if(ns >= target || iterations >= (1ull << 34)) return iterations;
+
+        double scale = ns > 0 ? target / ns * 1.1 : 10;
+        iterations = (uint64_t)(iterations * std::min(std::max(scale, 2.0), 10.0));
+    }
+}
+
+static Summary measure(const Benchmark& bench, const BenchConfig& config){
+    Summary s;
+    s.name = bench.name;
+    s.iterations = calibrate(bench, config.sampleMs);
+
+    std::vector<double> samples;
+    for(int i = 0; i < config.samples; i++) samples.push_back(bench.run(s.iterations) / s.iterations);
+    std::sort(samples.begin(), samples.end());
+
+    size_t n = samples.size();
+    s.min = samples.front();
+    s.max = samples.back();
+    s.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+
+    double sum = 0;
+    for(double v : samples) sum += v;
+    s.mean = sum / n;
+
+    double squares = 0;
+    for(double v : samples) squares += (v - s.mean) * (v - s.mean);
+    s.stddev = n > 1 ? std::sqrt(squares / (n - 1)) : 0;
+    return s;
+}
+
+// One benchmark per line, so the baseline reader only has to scan lines
+static bool writeJson(const std::string& path, const BenchConfig& config, const std::vector<Summary>& results){
+    std::ofstream out(path);
+    if(!out) return false;
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"samples\": " << config.samples << ",\n  \"sample_ms\": " << config.sampleMs
+        << ",\n  \"benchmarks\": [\n";
+    for(size_t i = 0; i < results.size(); i++){
+        const Summary& s = results[i];
+        out << "    {\"name\": \"" << s.name << "\", \"iterations\": " << s.iterations
+            << ", \"median_ns\": " << s.median << ", \"mean_ns\": " << s.mean
+            << ", \"stddev_ns\": " << s.stddev << ", \"min_ns\": " << s.min
+            << ", \"max_ns\": " << s.max << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return (bool)out;
+}
+
+// Reads the median of every benchmark from a file written by writeJson
+static bool readBaseline(const std::string& path, std::map<std::string, double>& medians){
+    std::ifstream in(path);
+    if(!in) return false;
+
+    std::string line;
+    while(std::getline(in, line)){
+        size_t name = line.find("\"name\": \"");
+        size_t median = line.find("\"median_ns\": ");
+        if(name == std::string::npos || median == std::string::npos) continue;
+
+        name += 9;
+        size_t end = line.find('"', name);
+        medians[line.substr(name, end - name)] = atof(line.c_str() + median + 13);
+    }
+    return true;
+}
+
+static void usage(const char *prog){
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --samples N        timed samples per benchmark (default 20)\n"
+              << "  --sample-ms N      target length of one sample (default 10)\n"
+              << "  --filter TEXT      only run benchmarks whose name contains TEXT\n"
+              << "  --json PATH        write the results as JSON\n"
+              << "  --baseline PATH    compare medians with a previous --json run\n"
+              << "  --threshold PCT    slowdown that counts as a regression (default 10)\n";
+}
+
+int main(int argc, char *argv[]){
+    BenchConfig config;
+
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if(arg == "--samples" && hasValue) config.samples = atoi(argv[++i]);
+        else if(arg == "--sample-ms" && hasValue) config.sampleMs = atoi(argv[++i]);
+        else if(arg == "--filter" && hasValue) config.filter = argv[++i];
+        else if(arg == "--json" && hasValue) config.jsonPath = argv[++i];
+        else if(arg == "--baseline" && hasValue) config.baselinePath = argv[++i];
+        else if(arg == "--threshold" && hasValue) config.threshold = atof(argv[++i]);
+        else{
+            usage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+    if(config.samples <= 0 || config.sampleMs <= 0){
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::map<std::string, double> baseline;
+    if(!config.baselinePath.empty() && !readBaseline(config.baselinePath, baseline)){
+        std::cerr << "Could not read baseline " << config.baselinePath << "\n";
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(32) << "benchmark" << std::right
+              << std::setw(12) << "median ns" << std::setw(10) << "mean" << std::setw(10) << "stddev"
+              << std::setw(10) << "min" << std::setw(10) << "max";
+    if(!baseline.empty()) std::cout << std::setw(10) << "vs base";
+    std::cout << "\n" << std::fixed;
+
+    std::vector<Summary> results;
+    int regressions = 0;
+    for(const Benchmark& bench : registerBenchmarks()){
+        if(!config.filter.empty() && bench.name.find(config.filter) == std::string::npos) continue;
+
+        Summary s = measure(bench, config);
+        results.push_back(s);
+
+        std::cout << std::left << std::setw(32) << s.name << std::right << std::setprecision(1)
+                  << std::setw(12) << s.median << std::setw(10) << s.mean << std::setw(10) << s.stddev
+                  << std::setw(10) << s.min << std::setw(10) << s.max;
+
+        auto base = baseline.find(s.name);
+        if(base != baseline.end() && base->second > 0){
+            double change = (s.median / base->second - 1) * 100;
+            std::cout << std::setw(9) << std::showpos << change << std::noshowpos << "%";
+            if(change > config.threshold){
+                std::cout << "  REGRESSION";
+                regressions++;
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    if(!config.jsonPath.empty() && !writeJson(config.jsonPath, config, results)){
+        std::cerr << "Could not write " << config.jsonPath << "\n";
+        return 1;
+    }
+    if(regressions > 0){
+        std::cout << "\n" << regressions << " benchmark(s) slower than the baseline by more than "
+                  << config.threshold << "%\n";
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <charconv>
+
+#include "actiontext.h"
+
+// One template per AbilityId. %n is the attacker's name, %d damage, %h heal, %b bonus, %m mana
+// left, and %t, %s and %k how many enemies an area ability hit, were shielded from it and killed.
+static const char* ABILITY_TEXT[ABILITY_COUNT] = {
+    "",
+    "%n attacks aggressively! Causes %d of damage.",
+    "%n uses Bloody Frenzy! Causes %d of damage and heals %h! Mana left: %m",
+    "%n uses Brutal Force! Causes %d of damage and bonus of %b% in next attack!",
+    "%n attacks with wisdom! Causes %d of damage.",
+    "%n uses Inherited Spell! Causes %d of damage! Mana left: %m",
+    "%n uses Divine Magic! Causes %d of damage and heals %h!",
+    "%n attacks with courage! Causes %d of damage.",
+    "%n uses Unexpected Luck! Next attack with a bonus of %b%! Mana left: %m",
+    "%n uses Traveler's Trick! Causes %d of damage and guarantees dodge in next turn!",
+    "%n uses Cleave! Causes %d of damage to every wounded enemy (%t hit, %s blocked, %k fell).",
+    "%n uses Arcane Nova! Causes %d of damage to every enemy (%t hit, %s blocked, %k fell)! Mana left: %m",
+    "%n uses Pebble Volley! Causes %d of damage to every enemy (%t hit, %s blocked, %k fell)! Mana left: %m"
+};
+
+// Indexed by BlockKind; %n is the target's name
+static const char* BLOCK_TEXT[] = {
+    "",
+    " %n blocks the attack with a Aegis Veil!",
+    " %n dodges the attack!"
+};
+
+static void appendNumber(std::string& out, int value){
+    char digits[12];
+    auto res = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, res.ptr - digits);
+}
+
+// Expands a template; a '%' not followed by a known field is copied as is
+static void appendTemplate(std::string& out, const char *text, std::string_view name, const ActionResult& result){
+    for(const char *p = text; *p; p++){
+        if(*p != '%'){
+            out.push_back(*p);
+            continue;
+        }
+
+        switch(p[1]){
+            case 'n': out.append(name); break;
+            case 'd': appendNumber(out, result.damage); break;
+            case 'h': appendNumber(out, result.heal); break;
+            case 'b': appendNumber(out, result.bonus); break;
+            case 'm': appendNumber(out, result.manaLeft); break;
+            case 't': appendNumber(out, result.hits); break;
+            case 'k': appendNumber(out, result.kills); break;
+            case 's': appendNumber(out, result.blocks); break;
+            default: out.push_back('%'); continue;
+        }
+        p++;
+    }
+}
+
+const char* actionErrorText(uint8_t error){
+    switch(error){
+        case ACTION_OK: return "";
+        case ERROR_NO_MANA: return "Mana is not sufficient!";
+        case ERROR_INVALID_ACTION: return "Invalid action type.";
+        default: return "Unknown error.";
+    }
+}
+
+void appendActionText(std::string& out, std::string_view attacker, std::string_view target, const ActionResult& result){
+    if(result.isError()){
+        out += actionErrorText(result.error);
+        return;
+    }
+
+    if(result.ability < ABILITY_COUNT) appendTemplate(out, ABILITY_TEXT[result.ability], attacker, result);
+    if(result.blocked < sizeof(BLOCK_TEXT) / sizeof(BLOCK_TEXT[0])) appendTemplate(out, BLOCK_TEXT[result.blocked], target, result);
+}
@@ -0,0 +1,21 @@
+#ifndef ACTIONTEXT_H
+#define ACTIONTEXT_H
+
+#include <string>
+#include <string_view>
+
+#include "character.h"
+
+// Narration of action results. Resolving an action only fills in numbers; whoever shows the
+// result to people (the server's frames, replay -v) turns them into text here, appending to a
+// buffer it can reuse.
+
+// Appends what the attacker's ability did, e.g. "Grok attacks aggressively! Causes 15 of damage.",
+// followed by how the target blocked it, if it did. Area abilities sum up their victims instead
+// of naming them. Errors append their message instead.
+void appendActionText(std::string& out, std::string_view attacker, std::string_view target, const ActionResult& result);
+
+// Message of an ActionError, e.g. "Mana is not sufficient!"
+const char* actionErrorText(uint8_t error);
+
+#endif
@@ -2,11 +2,11 @@
 
 // Constructor
 Character::Character(
+    ClassId classId,
     const std::string& name,
     int health,
-    int mana,
-    const std::map<std::string,int>& inventory) 
-    : name(name), health(health), mana(mana), inventory(inventory)
+    int mana) 
+    : classId(classId), name(name), health(health), mana(mana)
 {}
 
 // Check if character is alive
@@ -16,11 +16,19 @@ bool Character::isAlive() const{
 
 // Set health to zero
 void Character::setDead(){
+    if(health <= 0) return;
+    dirty |= DIRTY_HEALTH | DIRTY_STATUS;
     this->health = 0;
+    died();
+}
+
+// Tells the observer, if any, that health just reached zero
+void Character::died(){
+    if(deathObserver) deathObserver->onDeath(this);
 }
 
 // Getters
-std::string Character::getName() const{
+const std::string& Character::getName() const{
     return this->name;
 }
 
@@ -36,75 +44,78 @@ bool Character::getNextAttackProtected() const{
     return this->nextAttackProtected;
 }
 
-int Character::getTemporaryAttackBonusValue(){
-    return this->temporaryAttackBonus[0];
-}
-
-int Character::getTemporaryAttackBonusDuration(){
-    return this->temporaryAttackBonus[1];
+int Character::getAttackBonus() const{
+    return this->attackBonus;
 }
 
 // Calculate attack damage including temporary bonus
 int Character::getAttackDamage() {
-    return baseAttackDamage + (baseAttackDamage * temporaryAttackBonus[0] / 100);
+    return baseAttackDamage + (baseAttackDamage * attackBonus / 100);
 }
 
 // Setters
 void Character::setNextAttackProtected(bool nextAttackProtected){
+    if(this->nextAttackProtected != nextAttackProtected) dirty |= DIRTY_STATUS;
     this->nextAttackProtected = nextAttackProtected;
 }
 
-void Character::setTemporaryAttackBonus(int temporaryAttackBonus, int duration){
-    this->temporaryAttackBonus[0] = temporaryAttackBonus;
-    this->temporaryAttackBonus[1] = duration;
+void Character::setAttackBonus(int attackBonus){
+    if(this->attackBonus != attackBonus) dirty |= DIRTY_BONUS;
+    this->attackBonus = attackBonus;
+}
+
+void Character::spendMana(int amount){
+    if(amount != 0) dirty |= DIRTY_MANA;
+    this->mana -= amount;
 }
 
 // Modify health
 void Character::takeDamage(int dmg){
+    int before = health;
     this->health -= dmg;
     if(health < 0) health = 0;
+
+    if(health != before) dirty |= DIRTY_HEALTH;
+    if(before > 0 && health == 0){
+        dirty |= DIRTY_STATUS;
+        died();
+    }
 }
 
 void Character::gainHealth(int amt){
+    int before = health;
     this->health += amt;
     if(health > maxHealth) health = maxHealth;
+
+    if(health != before) dirty |= DIRTY_HEALTH;
 }
 
 // Inventory management
-void Character::addItem(const std::string& item){
-    inventory[item]++; 
+void Character::addItem(ItemId item){
+    if(inventory[item] < 255) inventory[item]++;
 }
 
-void Character::removeItem(const std::string& item){
-    auto it = inventory.find(item);
-    if(it != inventory.end()) {
-        it->second--;
-        if(it->second <= 0)
-            inventory.erase(it);
-    }
+void Character::removeItem(ItemId item){
+    if(inventory[item] > 0) inventory[item]--;
 }
 
 // Return inventory as string
 std::string Character::lookInventory() const {
     std::stringstream ss;
     ss << "Inventory:\n";
-    for (const auto& item : inventory) {
-        ss << "- " << item.first << ": " << item.second << "\n";
+    for(int i = 0; i < ITEM_COUNT; i++){
+        if(inventory[i] > 0) ss << "- " << itemName((ItemId)i) << ": " << (int)inventory[i] << "\n";
     }
     return ss.str();
 }
 
 // Use an item
-void Character::useItem(const std::string& item){
-    auto it = inventory.find(item);
-
-    if(it != inventory.end()){
-        it->second--;
-        if(it->second <= 0)
-            inventory.erase(it);
-        std::cout << name << " used " << item << "!\n";
+void Character::useItem(ItemId item){
+    if(inventory[item] > 0){
+        inventory[item]--;
+        std::cout << name << " used " << itemName(item) << "!\n";
     } 
     else {
-        std::cout << name << " does not have " << item << " in inventory!\n";
+        std::cout << name << " does not have " << itemName(item) << " in inventory!\n";
     }
 }
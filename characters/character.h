@@ -1,29 +1,120 @@
 #ifndef CHARACTER_H
 #define CHARACTER_H
 
+#include <climits>
 #include <iostream>
 #include <sstream>
 #include <string>
-#include <map>
+
+#include "items.h"
+#include "../rng.h"
+
+// Playable classes, in the order they are listed to players
+enum ClassId : uint8_t {
+    CLASS_HALFLING = 0,
+    CLASS_MAGE = 1,
+    CLASS_ORC = 2,
+    CLASS_COUNT = 3
+};
 
 enum ActionType {
     ATTACK = 0,
     CAST_SPELL = 1,
-    SPECIAL_MOVE = 2
+    SPECIAL_MOVE = 2,
+    AREA_ATTACK = 3, // Hits every enemy within the ability's reach; takes no target
+    ACTION_COUNT = 4
+};
+
+// State that changed since the last takeDirty(), so only changes are sent to clients
+enum DirtyField : uint8_t {
+    DIRTY_HEALTH = 1,
+    DIRTY_MANA = 2,
+    DIRTY_STATUS = 4, // Alive or protection
+    DIRTY_BONUS = 8
+};
+
+// Ability an action resolved to. Its text is only built where someone reads it (actiontext.h).
+enum AbilityId : uint8_t {
+    ABILITY_NONE = 0,
+    ABILITY_ORC_ATTACK,
+    ABILITY_BLOODY_FRENZY,
+    ABILITY_BRUTAL_FORCE,
+    ABILITY_MAGE_ATTACK,
+    ABILITY_INHERITED_SPELL,
+    ABILITY_DIVINE_MAGIC,
+    ABILITY_HALFLING_ATTACK,
+    ABILITY_UNEXPECTED_LUCK,
+    ABILITY_TRAVELERS_TRICK,
+    ABILITY_CLEAVE,
+    ABILITY_ARCANE_NOVA,
+    ABILITY_PEBBLE_VOLLEY,
+    ABILITY_COUNT
 };
 
-// Result of an action (damage, healing, or error)
+enum ActionError : uint8_t {
+    ACTION_OK = 0,
+    ERROR_NO_MANA,
+    ERROR_INVALID_ACTION
+};
+
+// How a protected target avoided the damage
+enum BlockKind : uint8_t {
+    BLOCK_NONE = 0,
+    BLOCK_AEGIS_VEIL,
+    BLOCK_DODGE
+};
+
+// Temporary effects an action can leave on its attacker; the battle's EffectTable keeps them
+enum EffectType : uint8_t {
+    EFFECT_NONE = 0,
+    EFFECT_ATTACK_BONUS, // Percent added to attack damage
+    EFFECT_PROTECTED,    // The next attack on the player is blocked
+    EFFECT_TYPE_COUNT
+};
+
+#define EFFECT_UNTIL_CONSUMED -1 // Duration of an effect that lasts until something uses it up
+
+#define REACH_EVERYONE INT_MAX // Reach of an area ability that hits enemies at any health
+
+// Result of an action (damage, healing, or error) as plain numbers, so resolving it allocates nothing
 struct ActionResult {
-    std::string message;
+    uint8_t ability = ABILITY_NONE;
+    uint8_t error = ACTION_OK;
+    uint8_t blocked = BLOCK_NONE;
+    uint8_t effect = EFFECT_NONE; // Granted to the attacker once the action resolves
     int damage = 0;
     int heal = 0;
-    bool isError = false;
+    int bonus = 0;     // Percent attack bonus granted by the ability
+    int manaLeft = 0;  // After abilities that cost mana
+    int effectValue = 0;
+    int effectTurns = 0; // Attacker's actions the effect lasts, or EFFECT_UNTIL_CONSUMED
+
+    // Area actions: damage is what each enemy hit takes, and only enemies with at most reach health
+    // are hit. The battle fills in how many were hit, blocked it or died.
+    int reach = 0;
+    int hits = 0;
+    int blocks = 0;
+    int kills = 0;
+
+    bool isError() const { return error != ACTION_OK; }
+};
+
+class Character;
+
+// Told when a character's health reaches zero, by takeDamage or setDead
+class DeathObserver {
+    public:
+        virtual void onDeath(Character *c) = 0;
+
+    protected:
+        ~DeathObserver() = default;
 };
 
 // Base class for game characters
 class Character {
     protected:
-        int socketIndex;
+        ClassId classId;
+        uint64_t clientId = 0; // Handle of the connection playing it in the server's registry, 0 = none
 
         std::string name;
         int health;
@@ -32,50 +123,72 @@ class Character {
         int maxHealth = 100;
         int maxMana = 100;
         
-        bool nextAttackProtected;
+        // Totals of the active effects, kept up to date by the battle's EffectTable
+        bool nextAttackProtected = false;
+        int attackBonus = 0; // Percent
+
         int baseAttackDamage;
-        int temporaryAttackBonus[2] = {0, 0};
 
-        std::map<std::string, int> inventory;
+        uint8_t inventory[ITEM_COUNT] = {}; // Count per ItemId, saturating at 255
+
+        uint8_t dirty = 0; // DirtyField bits
+
+        DeathObserver *deathObserver = nullptr;
+        int rosterIndex = -1; // Position in the observer's roster
+
+        void died();
+
+        void spendMana(int amount);
         
     public:
-        Character(const std::string& name, int health, int mana, const std::map<std::string,int>& inventory);
+        Character(ClassId classId, const std::string& name, int health, int mana);
         virtual ~Character() = default;
 
-        virtual ActionResult attack() = 0;   
-        virtual ActionResult castSpell() = 0;
-        virtual ActionResult specialMove() = 0;
+        // Actions draw any randomness from the match's generator
+        virtual ActionResult attack(Rng& rng) = 0;
+        virtual ActionResult castSpell(Rng& rng) = 0;
+        virtual ActionResult specialMove(Rng& rng) = 0;
+        virtual ActionResult areaAttack(Rng& rng) = 0;
 
-        // Socket
-        void setSocketIndex(int idx) { socketIndex = idx; }
-        int getSocketIndex() const { return socketIndex; }
+        // Connection
+        void setClientId(uint64_t id) { clientId = id; }
+        uint64_t getClientId() const { return clientId; }
 
         // Stats
-        std::string getName() const;
+        const std::string& getName() const;
         virtual std::string getClass() const = 0;
+        ClassId getClassId() const { return classId; }
 
         int getHealth() const;
         int getMana() const;
         bool isAlive() const;
         void setDead();
         bool getNextAttackProtected() const;
-        int getTemporaryAttackBonusDuration();
-        int getTemporaryAttackBonusValue();
+        int getAttackBonus() const;
 
+        // Set from the effects in play; actions grant effects through ActionResult instead
         void setNextAttackProtected(bool nextAttackProtected);
-        void setTemporaryAttackBonus(int temporaryAttackBonusValue, int duration);
+        void setAttackBonus(int attackBonus);
+
+        // Registers the battle that tracks this character as its index-th player; nullptr to stop
+        void observeDeath(DeathObserver *observer, int index) { deathObserver = observer; rosterIndex = index; }
+        int getRosterIndex() const { return rosterIndex; }
+
+        // Returns the DirtyField bits set since the last call and clears them
+        uint8_t takeDirty() { uint8_t d = dirty; dirty = 0; return d; }
 
         // Attack
         int getAttackDamage();
         void takeDamage(int dmg);
         void gainHealth(int amt);
-        virtual void handleAttackProtection() = 0;
+        virtual BlockKind handleAttackProtection() = 0; // How the protection absorbed an attack
 
         // Inventory
-        void addItem(const std::string& item);      
-        void removeItem(const std::string& item);   
-        std::string lookInventory() const; 
-        void useItem(const std::string& item);         
+        void addItem(ItemId item);
+        void removeItem(ItemId item);
+        int itemCount(ItemId item) const { return inventory[item]; }
+        std::string lookInventory() const;
+        void useItem(ItemId item);
 };
 
 #endif
@@ -0,0 +1,28 @@
+#ifndef CLASSES_H
+#define CLASSES_H
+
+#include <variant>
+
+#include "halfling.h"
+#include "mage.h"
+#include "orc.h"
+
+// The closed set of playable classes. A roster of AnyCharacter keeps every character by value in
+// one contiguous block, and dispatchClass reaches the concrete class with a switch instead of a
+// virtual call.
+
+// Alternatives in ClassId order
+using AnyCharacter = std::variant<Halfling, Mage, Orc>;
+
+// Calls f with c as its concrete class. The classes are final, so calls f makes through that
+// reference are direct and can be inlined.
+template <typename F>
+inline decltype(auto) dispatchClass(Character& c, F&& f){
+    switch(c.getClassId()){
+        case CLASS_MAGE: return f(static_cast<Mage&>(c));
+        case CLASS_ORC: return f(static_cast<Orc&>(c));
+        default: return f(static_cast<Halfling&>(c));
+    }
+}
+
+#endif
@@ -0,0 +1,28 @@
+#include "factory.h"
+#include "halfling.h"
+#include "mage.h"
+#include "orc.h"
+
+static const char* CLASS_NAMES[CLASS_COUNT] = {"Halfling", "Mage", "Orc"};
+
+bool parseClassName(const std::string& classType, ClassId& id){
+    for(int i = 0; i < CLASS_COUNT; i++){
+        if(classType == CLASS_NAMES[i]){
+            id = (ClassId)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* className(ClassId id){
+    return CLASS_NAMES[id];
+}
+
+Character& emplaceCharacter(std::vector<AnyCharacter>& roster, ClassId id, const std::string& name){
+    switch(id){
+        case CLASS_MAGE: return std::get<Mage>(roster.emplace_back(std::in_place_type<Mage>, name));
+        case CLASS_ORC: return std::get<Orc>(roster.emplace_back(std::in_place_type<Orc>, name));
+        default: return std::get<Halfling>(roster.emplace_back(std::in_place_type<Halfling>, name));
+    }
+}
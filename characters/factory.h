@@ -0,0 +1,19 @@
+#ifndef FACTORY_H
+#define FACTORY_H
+
+#include <string>
+#include <vector>
+
+#include "character.h"
+#include "classes.h"
+
+// Looks up a class by name ("Halfling", "Mage", "Orc"). Returns false for unknown names.
+bool parseClassName(const std::string& classType, ClassId& id);
+
+const char* className(ClassId id);
+
+// Appends a character of the given class to roster, by value. Pointers into roster stay valid
+// while it does not grow past its capacity, so reserve it first.
+Character& emplaceCharacter(std::vector<AnyCharacter>& roster, ClassId id, const std::string& name);
+
+#endif
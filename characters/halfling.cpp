@@ -3,18 +3,14 @@
 
 // Constructor: sets base stats and starting items
 Halfling::Halfling(const std::string& name) 
-    : Character(name, 85, 15, std::map<std::string,int>{}) 
+    : Character(CLASS_HALFLING, name, 85, 15) 
 {
     baseAttackDamage = 10;
-    nextAttackProtected = false;
     maxHealth = 85;
 
     // Initial items
-    addItem("Halfling Pipe");
-    addItem("Apple Pie");
-
-    std::cout << "A Halfling named " << name << " was created! Life: " 
-              << this->getHealth() << " Mana: " << this->getMana() << std::endl;
+    addItem(ITEM_HALFLING_PIPE);
+    addItem(ITEM_APPLE_PIE);
 }
 
 std::string Halfling::getClass() const{
@@ -22,50 +18,65 @@ std::string Halfling::getClass() const{
 }
 
 // Basic attack
-ActionResult Halfling::attack(){
+ActionResult Halfling::attack(Rng& rng){
     int damage = getAttackDamage();
 
-    ActionResult action = {
-        .message = name + " attacks with courage! Causes " + std::to_string(damage) + " of damage.",
-        .damage = damage
-    };
-                            
+    ActionResult action;
+    action.ability = ABILITY_HALFLING_ATTACK;
+    action.damage = damage;
     return action;
 }
 
 // Spell: gives a temporary attack bonus if enough mana
-ActionResult Halfling::castSpell() {
+ActionResult Halfling::castSpell(Rng& rng) {
     ActionResult action;
     if(mana >= 10){
-        mana -= 10;
-        int bonus = rand() % 200 + 150;
-        this->setTemporaryAttackBonus(bonus, 1);
+        spendMana(10);
+        int bonus = rng.range(150, 349);
 
-        action.message = name + " uses Unexpected Luck! Next attack with a bonus of " 
-                         + std::to_string(bonus) + "%! Mana left: " + std::to_string(mana);
+        action.ability = ABILITY_UNEXPECTED_LUCK;
+        action.bonus = bonus;
+        action.manaLeft = mana;
+        action.effect = EFFECT_ATTACK_BONUS;
+        action.effectValue = bonus;
+        action.effectTurns = 1;
     } 
     else{
-        action.message = "Mana is not sufficient!";
-        action.isError = true;
+        action.error = ERROR_NO_MANA;
     }
     return action;
 }
 
 // Special move: causes damage and protects from next attack
-ActionResult Halfling::specialMove() {
-    this->nextAttackProtected = true;
-
+ActionResult Halfling::specialMove(Rng& rng) {
     int damage = 15;
-    ActionResult action = {
-        .message = name + " uses Traveler's Trick! Causes " + std::to_string(damage) 
-                   + " of damage and guarantees dodge in next turn!",
-        .damage = damage
-    };
+    ActionResult action;
+    action.ability = ABILITY_TRAVELERS_TRICK;
+    action.damage = damage;
+    action.effect = EFFECT_PROTECTED;
+    action.effectTurns = EFFECT_UNTIL_CONSUMED;
+
+    return action;
+}
+
+// Area: spends all its mana pelting every enemy
+ActionResult Halfling::areaAttack(Rng& rng) {
+    ActionResult action;
+    if(mana >= 15){
+        spendMana(15);
 
+        action.ability = ABILITY_PEBBLE_VOLLEY;
+        action.damage = 5;
+        action.reach = REACH_EVERYONE;
+        action.manaLeft = mana;
+    }
+    else{
+        action.error = ERROR_NO_MANA;
+    }
     return action;
 }
 
 // Handle protection effect when attacked
-void Halfling::handleAttackProtection(){
-    std::cout << name << " dodges the attack!\n";
+BlockKind Halfling::handleAttackProtection(){
+    return BLOCK_DODGE;
 }
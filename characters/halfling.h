@@ -4,18 +4,19 @@
 #include "character.h"
 
 // Halfling class: a small, nimble character with unique attack and protection abilities
-class Halfling : public Character {
+class Halfling final : public Character {
     public:
         Halfling(const std::string& name);  // Constructor: sets stats and starting items
 
         std::string getClass() const override;
 
         // Overridden actions
-        ActionResult attack() override;       
-        ActionResult castSpell() override;    
-        ActionResult specialMove() override;  
+        ActionResult attack(Rng& rng) override;       
+        ActionResult castSpell(Rng& rng) override;    
+        ActionResult specialMove(Rng& rng) override;  
+        ActionResult areaAttack(Rng& rng) override;   
 
-        void handleAttackProtection() override; 
+        BlockKind handleAttackProtection() override; 
 };
 
 #endif
@@ -0,0 +1,17 @@
+#include "items.h"
+
+static const char* ITEM_NAMES[ITEM_COUNT] = {"Apple Pie", "Halfling Pipe", "Magical Herbs", "Rope"};
+
+bool parseItemName(std::string_view name, ItemId& id){
+    for(int i = 0; i < ITEM_COUNT; i++){
+        if(name == ITEM_NAMES[i]){
+            id = (ItemId)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* itemName(ItemId id){
+    return id < ITEM_COUNT ? ITEM_NAMES[id] : "?";
+}
@@ -0,0 +1,22 @@
+#ifndef ITEMS_H
+#define ITEMS_H
+
+#include <cstdint>
+#include <string_view>
+
+// Item registry: every item kind has a compact id, so inventories are a fixed array of counts
+// instead of a map keyed by name. Names are only looked up at the edges (parsing, display).
+enum ItemId : uint8_t {
+    ITEM_APPLE_PIE = 0,
+    ITEM_HALFLING_PIPE,
+    ITEM_MAGICAL_HERBS,
+    ITEM_ROPE,
+    ITEM_COUNT
+};
+
+// Looks up an item by name ("Rope", ...). Returns false for unknown names.
+bool parseItemName(std::string_view name, ItemId& id);
+
+const char* itemName(ItemId id);
+
+#endif
@@ -3,17 +3,13 @@
 
 // Constructor: sets base stats and starting items
 Mage::Mage(const std::string& name) 
-    : Character(name, 65, 100, std::map<std::string,int>{}) 
+    : Character(CLASS_MAGE, name, 65, 100) 
 {
     baseAttackDamage = 10;
-    nextAttackProtected = false;
     maxHealth = 65;
 
     // Initial item
-    addItem("Magical Herbs");
-
-    std::cout << "A Mage named " << name << " was created! Life: " 
-              << this->getHealth() << " Mana: " << this->getMana() << std::endl;
+    addItem(ITEM_MAGICAL_HERBS);
 }
 
 std::string Mage::getClass() const{
@@ -21,52 +17,66 @@ std::string Mage::getClass() const{
 }
 
 // Basic attack with small chance to gain protection
-ActionResult Mage::attack(){
+ActionResult Mage::attack(Rng& rng){
     int damage = getAttackDamage();
 
-    if((rand() % 100) < 10) this->nextAttackProtected = true;
-
-    ActionResult action = {
-        .message = name + " attacks with wisdom! Causes " + std::to_string(damage) + " of damage.",
-        .damage = damage
-    };
-              
+    ActionResult action;
+    action.ability = ABILITY_MAGE_ATTACK;
+    action.damage = damage;
+    if(rng.below(100) < 10){
+        action.effect = EFFECT_PROTECTED;
+        action.effectTurns = EFFECT_UNTIL_CONSUMED;
+    }
     return action;
 }
 
 // Spell: costs mana and deals fixed damage
-ActionResult Mage::castSpell() {
+ActionResult Mage::castSpell(Rng& rng) {
     ActionResult action;
     if(mana >= 30){
-        mana -= 30;
+        spendMana(30);
         int damage = 25;
 
-        action.message = name + " uses Inherited Spell! Causes " + std::to_string(damage) 
-                         + " of damage! Mana left: " + std::to_string(mana);
+        action.ability = ABILITY_INHERITED_SPELL;
         action.damage = damage;
+        action.manaLeft = mana;
     } 
     else{
-        action.message = "Mana is not sufficient!";
-        action.isError = true;
+        action.error = ERROR_NO_MANA;
     }
     return action;
 }
 
 // Special move: small damage and healing
-ActionResult Mage::specialMove() {
+ActionResult Mage::specialMove(Rng& rng) {
     int damage = 5;
     int heal = 15;
-    ActionResult action = {
-        .message = name + " uses Divine Magic! Causes " + std::to_string(damage) 
-                   + " of damage and heals " + std::to_string(heal) + "!",
-        .damage = damage,
-        .heal = heal
-    };
+    ActionResult action;
+    action.ability = ABILITY_DIVINE_MAGIC;
+    action.damage = damage;
+    action.heal = heal;
 
     return action;
 }
 
+// Area: costs mana and hits every enemy with a fixed blast
+ActionResult Mage::areaAttack(Rng& rng) {
+    ActionResult action;
+    if(mana >= 50){
+        spendMana(50);
+
+        action.ability = ABILITY_ARCANE_NOVA;
+        action.damage = 10;
+        action.reach = REACH_EVERYONE;
+        action.manaLeft = mana;
+    }
+    else{
+        action.error = ERROR_NO_MANA;
+    }
+    return action;
+}
+
 // Handle protection effect when attacked
-void Mage::handleAttackProtection(){
-    std::cout << name << " blocks the attack with a Aegis Veil!\n";
+BlockKind Mage::handleAttackProtection(){
+    return BLOCK_AEGIS_VEIL;
 }
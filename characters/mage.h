@@ -4,18 +4,19 @@
 #include "character.h"
 
 // Mage class: a spellcaster with high mana and healing abilities
-class Mage : public Character {
+class Mage final : public Character {
     public:
         Mage(const std::string& name);  // Constructor: sets stats and starting items
 
         std::string getClass() const override;
 
         // Overridden actions
-        ActionResult attack() override;       
-        ActionResult castSpell() override;    
-        ActionResult specialMove() override;  
+        ActionResult attack(Rng& rng) override;       
+        ActionResult castSpell(Rng& rng) override;    
+        ActionResult specialMove(Rng& rng) override;  
+        ActionResult areaAttack(Rng& rng) override;   
 
-        void handleAttackProtection() override; 
+        BlockKind handleAttackProtection() override; 
 };
 
 #endif
@@ -3,17 +3,13 @@
 
 // Constructor: sets base stats and starting items
 Orc::Orc(const std::string& name) 
-    : Character(name, 90, 10, std::map<std::string,int>{}) 
+    : Character(CLASS_ORC, name, 90, 10) 
 {
     baseAttackDamage = 15;
-    nextAttackProtected = false;
     maxHealth = 90;
 
     // Initial item
-    addItem("Rope");
-
-    std::cout << "An Orc named " << name << " was created! Life: " 
-              << this->getHealth() << " Mana: " << this->getMana() << std::endl;
+    addItem(ITEM_ROPE);
 }
 
 std::string Orc::getClass() const{
@@ -21,52 +17,60 @@ std::string Orc::getClass() const{
 }
 
 // Basic attack
-ActionResult Orc::attack(){
+ActionResult Orc::attack(Rng& rng){
     int damage = getAttackDamage();
 
-    ActionResult action = {
-        .message = name + " attacks aggressively! Causes " + std::to_string(damage) + " of damage.",
-        .damage = damage
-    };
-              
+    ActionResult action;
+    action.ability = ABILITY_ORC_ATTACK;
+    action.damage = damage;
     return action;
 }
 
 // Spell: costs mana, deals damage and heals
-ActionResult Orc::castSpell() {
+ActionResult Orc::castSpell(Rng& rng) {
     ActionResult action;
     if(mana >= 5){
-        mana -= 5;
+        spendMana(5);
         int damage = 10;
         int heal = 5;
 
-        action.message = name + " uses Bloody Frenzy! Causes " + std::to_string(damage) 
-                         + " of damage and heals " + std::to_string(heal) 
-                         + "! Mana left: " + std::to_string(mana);
+        action.ability = ABILITY_BLOODY_FRENZY;
         action.damage = damage;
         action.heal = heal;
+        action.manaLeft = mana;
     } 
     else{
-        action.message = "Mana is not sufficient!";
-        action.isError = true;
+        action.error = ERROR_NO_MANA;
     }
     return action;
 }
 
 // Special move: high damage and temporary attack bonus
-ActionResult Orc::specialMove() {
+ActionResult Orc::specialMove(Rng& rng) {
     int damage = 25;
-    int bonus = rand() % 75 + 25;
-    this->setTemporaryAttackBonus(bonus, 1);
+    int bonus = rng.range(25, 99);
+
+    ActionResult action;
+    action.ability = ABILITY_BRUTAL_FORCE;
+    action.damage = damage;
+    action.bonus = bonus;
+    action.effect = EFFECT_ATTACK_BONUS;
+    action.effectValue = bonus;
+    action.effectTurns = 1;
 
-    ActionResult action = {
-        .message = name + " uses Brutal Force! Causes " + std::to_string(damage) 
-                   + " of damage and bonus of " + std::to_string(bonus) + "% in next attack!",
-        .damage = damage
-    };
+    return action;
+}
 
+// Area: a full attack on every enemy weak enough to be finished off
+ActionResult Orc::areaAttack(Rng& rng) {
+    ActionResult action;
+    action.ability = ABILITY_CLEAVE;
+    action.damage = getAttackDamage();
+    action.reach = 30;
     return action;
 }
 
 // Orc has no special attack protection
-void Orc::handleAttackProtection(){}
+BlockKind Orc::handleAttackProtection(){
+    return BLOCK_NONE;
+}
@@ -4,17 +4,18 @@
 #include "character.h"
 
 // Orc class: strong and aggressive character with healing and high-damage abilities
-class Orc : public Character{
+class Orc final : public Character {
     public:
         Orc(const std::string& name);  // Constructor: sets stats and starting items
 
         std::string getClass() const override;
 
-        ActionResult attack() override;
-        ActionResult castSpell() override; 
-        ActionResult specialMove() override;
+        ActionResult attack(Rng& rng) override;
+        ActionResult castSpell(Rng& rng) override; 
+        ActionResult specialMove(Rng& rng) override;
+        ActionResult areaAttack(Rng& rng) override;
 
-        void handleAttackProtection() override;
+        BlockKind handleAttackProtection() override;
 };
 
 #endif
@@ -1,107 +1,274 @@
 #include <arpa/inet.h>
+#include <poll.h>
 #include <unistd.h>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <cstdlib>
 #include <cstring>
-#include <thread>
-#include <atomic>
-#include <sys/select.h>
+#include <cerrno>
+#include <charconv>
 
 #include "constants.h"
+#include "protocol.h"
+#include "recvbuffer.h"
 
-std::atomic<bool> running{true};
+#define CLIENT_RECV_BUFFER_SIZE 4096
+#define STDIN_BUFFER_SIZE 1024
 
-// Thread to receive messages from the server
-void receiveMessages(int sock) {
-    char buffer[1024];
-    while(running.load()){
-        memset(buffer, 0, sizeof(buffer));
-        int valread = read(sock, buffer, sizeof(buffer)-1);
-        if(valread <= 0){
-            running.store(false); // server closed
-            break;
-        }
+int lastPrompt = -1; // PromptKind of the last prompt shown, -1 if none
 
-        buffer[valread] = '\0';
-        std::string message(buffer);
+// Local copy of the battle state, kept up to date from MSG_SNAPSHOT and MSG_DELTA frames
+struct PlayerView {
+    std::string name;
+    std::string className;
+    int health = 0;
+    int mana = 0;
+    uint8_t flags = 0;
+    int attackBonus = 0;
+};
 
-        // Check if it is an input prompt
-        if(message.rfind(INPUT, 0) == 0){ // starts with INPUT
-            // Remove "INPUT" + space
-            std::string prompt = message.substr(strlen(INPUT) + 1);
-            std::cout << prompt << std::flush;
-            continue; // do not print the rest
-        }
+std::vector<PlayerView> roster;
+uint32_t rosterSeq = 0;
+uint32_t self = NO_PLAYER;
+bool haveSnapshot = false;
+bool resyncPending = false;
 
-        // Process messages containing '\r'
-        size_t pos = 0;
-        while((pos = message.find('\r')) != std::string::npos){
-            std::cout << message.substr(0, pos) << "\r" << std::flush;
-            message = message.substr(pos + 1);
-        }
+void printStatus(const char *title){
+    std::cout << "\n==== " << title << " ====\n";
+    for(size_t i = 0; i < roster.size(); i++){
+        const PlayerView& p = roster[i];
+        std::cout << i << ": " << p.name << " (" << p.className << ", HP: " << p.health << ", Mana: " << p.mana;
+        if(p.attackBonus) std::cout << ", +" << p.attackBonus << "% attack";
+        if(p.flags & PLAYER_PROTECTED) std::cout << ", Protected";
+        std::cout << ", " << ((p.flags & PLAYER_ALIVE) ? "Alive" : "Dead") << ")\n";
+    }
+    std::cout << "================================\n\n" << std::flush;
+}
+
+// Lists the living opponents from the local roster; the server only sends the prompt
+void printTargets(){
+    for(size_t i = 0; i < roster.size(); i++){
+        const PlayerView& p = roster[i];
+        if(i == self || !(p.flags & PLAYER_ALIVE)) continue;
+        std::cout << i << ": " << p.name << " (HP: " << p.health << ")\n";
+    }
+    std::cout << std::flush;
+}
+
+void requestResync(int sock){
+    if(resyncPending) return;
+    resyncPending = true;
+    std::string frame;
+    encodeResync(frame);
+    send(sock, frame.data(), frame.size(), 0);
+}
+
+void applySnapshot(const Frame& frame){
+    FrameReader r(frame);
+    uint32_t count;
+    if(!decodeSnapshotHeader(r, rosterSeq, self, count)) return;
 
-        if(!message.empty()){
-            std::cout << message << std::flush;
+    roster.assign(count, PlayerView());
+    PlayerState player;
+    for(uint32_t i = 0; i < count && decodeSnapshotEntry(r, player); i++){
+        if(player.index >= count) continue;
+        PlayerView& p = roster[player.index];
+        p.name = player.name;
+        p.className = player.className;
+        p.health = player.health;
+        p.mana = player.mana;
+        p.flags = player.flags;
+        p.attackBonus = player.attackBonus;
+    }
+    haveSnapshot = true;
+    resyncPending = false;
+    printStatus("Players");
+}
+
+// Applies a delta on top of the local roster. A gap in the sequence means an update was missed,
+// so the roster is stale until a fresh snapshot arrives.
+void applyDelta(int sock, const Frame& frame){
+    FrameReader r(frame);
+    uint32_t seq, count;
+    if(!decodeDeltaHeader(r, seq, count)) return;
+
+    if(!haveSnapshot || seq != rosterSeq + 1){
+        requestResync(sock);
+        return;
+    }
+    rosterSeq = seq;
+
+    uint8_t fields;
+    PlayerState player;
+    for(uint32_t i = 0; i < count && decodeDeltaEntry(r, fields, player); i++){
+        if(player.index >= roster.size()) continue;
+        PlayerView& p = roster[player.index];
+        if(fields & FIELD_HEALTH) p.health = player.health;
+        if(fields & FIELD_MANA) p.mana = player.mana;
+        if(fields & FIELD_FLAGS) p.flags = player.flags;
+        if(fields & FIELD_BONUS) p.attackBonus = player.attackBonus;
+    }
+    printStatus("Status after this turn");
+}
+
+// Prints one decoded frame. Returns false if the server is closing the connection.
+bool handleFrame(int sock, const Frame& frame){
+    switch(frame.type){
+        case MSG_TEXT: {
+            TextMessage msg;
+            if(decodeText(frame, msg)) std::cout << msg.text << std::flush;
+            return true;
+        }
+        case MSG_PROMPT: {
+            PromptMessage msg;
+            if(decodePrompt(frame, msg)){
+                lastPrompt = msg.kind;
+                std::cout << msg.text << std::flush;
+                if(msg.kind == PROMPT_TARGET) printTargets();
+            }
+            return true;
         }
+        case MSG_ACTION_RESULT: {
+            ActionResultMessage msg;
+            if(decodeActionResult(frame, msg)) std::cout << msg.text << std::flush;
+            return true;
+        }
+        case MSG_SNAPSHOT:
+            applySnapshot(frame);
+            return true;
+        case MSG_DELTA:
+            applyDelta(sock, frame);
+            return true;
+        case MSG_SHUTDOWN: {
+            std::string_view reason;
+            if(decodeShutdown(frame, reason)) std::cout << reason << std::flush;
+            return false;
+        }
+        default:
+            return true; // Unknown types from newer servers are skipped
+    }
+}
 
-        // Detect server shutdown
-        if(message.find("Server shutting down") != std::string::npos){
-            running.store(false);
-            break;
+// Encodes a line typed by the user. Numbers typed at the action/target prompts are sent as
+// MSG_ACTION_REQUEST, and so is "action target" at any time, which the server plays at once or
+// keeps for the player's next turn. Everything else goes as free text.
+std::string encodeUserLine(std::string_view line){
+    std::string frame;
+    int prompt = lastPrompt;
+    const char *end = line.data() + line.size();
+
+    int value;
+    auto res = std::from_chars(line.data(), end, value);
+    bool isNumber = res.ec == std::errc() && res.ptr == end;
+
+    int target;
+    if(res.ec == std::errc() && res.ptr < end && *res.ptr == ' '){
+        auto second = std::from_chars(res.ptr + 1, end, target);
+        if(second.ec == std::errc() && second.ptr == end){
+            ActionRequestMessage request;
+            request.action = value;
+            request.target = target;
+            encodeActionRequest(frame, request);
+            return frame;
         }
     }
+
+    if(isNumber && (prompt == PROMPT_ACTION || prompt == PROMPT_TARGET)){
+        ActionRequestMessage request;
+        if(prompt == PROMPT_ACTION) request.action = value;
+        else request.target = value;
+        encodeActionRequest(frame, request);
+    }
+    else{
+        encodeInput(frame, line);
+    }
+    return frame;
+}
+
+static void usage(const char *prog){
+    std::cerr << "Usage: " << prog << " [--host ADDR] [--port N]\n"
+              << "  --host ADDR   server IPv4 address (default 127.0.0.1)\n"
+              << "  --port N      server port (default " << PORT << ")\n";
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    std::string host = "127.0.0.1";
+    int port = PORT;
+
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if(arg == "--host" && hasValue) host = argv[++i];
+        else if(arg == "--port" && hasValue) port = atoi(argv[++i]);
+        else{
+            usage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
     int sock = socket(AF_INET, SOCK_STREAM, 0);
     if(sock < 0){
-        std::cerr << "Error creating socket\n"; 
+        std::cerr << "Error creating socket\n";
         return 1;
     }
 
     struct sockaddr_in serv_addr;
     serv_addr.sin_family = AF_INET;
-    serv_addr.sin_port = htons(PORT);
-    if(inet_pton(AF_INET, "127.0.0.1", &serv_addr.sin_addr) <= 0){
-        std::cerr << "Invalid address\n"; 
+    serv_addr.sin_port = htons(port);
+    if(inet_pton(AF_INET, host.c_str(), &serv_addr.sin_addr) <= 0){
+        std::cerr << "Invalid address\n";
         return 1;
     }
 
     if(connect(sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) < 0){
-        std::cerr << "Connection failed\n"; 
+        std::cerr << "Connection failed\n";
         return 1;
     }
 
-    // Thread to receive messages asynchronously
-    std::thread recvThread(receiveMessages, sock);
-
-    // Main loop: use select to avoid blocking on stdin
-    while(running.load()){
-        fd_set readfds;
-        FD_ZERO(&readfds);
-        FD_SET(STDIN_FILENO, &readfds);
+    // Single event loop: wait for the server or the keyboard, with no timeout
+    RecvBuffer inbox(CLIENT_RECV_BUFFER_SIZE, FRAME_HEADER_SIZE + MAX_FRAME_PAYLOAD);
+    RecvBuffer keyboard(STDIN_BUFFER_SIZE);
+    bool running = true;
 
-        struct timeval tv;
-        tv.tv_sec = 0;
-        tv.tv_usec = 100000; // 0.1s
+    while(running){
+        struct pollfd fds[2] = {{sock, POLLIN, 0}, {STDIN_FILENO, POLLIN, 0}};
+        if(poll(fds, 2, -1) < 0){
+            if(errno == EINTR) continue;
+            perror("poll");
+            break;
+        }
 
-        int activity = select(STDIN_FILENO + 1, &readfds, NULL, NULL, &tv);
+        if(fds[0].revents){
+            if(inbox.fill(sock) != FILL_OK) break; // Server closed
 
-        if(activity > 0 && FD_ISSET(STDIN_FILENO, &readfds)){
-            std::string input;
-            if(!std::getline(std::cin, input)){
-                running.store(false);
+            // TCP may split or merge frames, so decode every complete one and keep the rest
+            Frame frame;
+            DecodeStatus status;
+            while(running && (status = inbox.nextFrame(frame)) == DECODE_OK){
+                running = handleFrame(sock, frame); // False once the server shuts down
+            }
+            if(running && status == DECODE_MALFORMED){
+                std::cerr << "Invalid message from server (protocol version " << PROTOCOL_VERSION << " expected)\n";
                 break;
             }
-            input += "\n";
-            send(sock, input.c_str(), input.size(), 0);
         }
 
-        if(!running.load()) break;
+        if(running && fds[1].revents){
+            FillStatus status = keyboard.fill(STDIN_FILENO);
+            std::string_view line;
+            DecodeStatus lineStatus;
+            while((lineStatus = keyboard.nextLine(line)) == DECODE_OK){
+                std::string frame = encodeUserLine(line);
+                send(sock, frame.data(), frame.size(), 0);
+            }
+            if(lineStatus == DECODE_MALFORMED) keyboard.clear(); // Line too long, drop it
+            if(status != FILL_OK) break; // End of input
+        }
     }
 
-    // Wait for receiver thread to finish
-    if(recvThread.joinable()) recvThread.join();
     close(sock);
 
     return 0;
@@ -1,16 +1,27 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+// Defaults for the server settings; server.conf and command line flags override them (serverconfig.h)
+
 // Network Settings 
 #define PORT 5050
 #define MAX_PLAYERS 6
 #define MIN_PLAYERS 2
 #define LOBBY_TIME 5 // seconds
 
-// Protocol Keywords
-#define INPUT "INPUT"
-#define SYS   "SYS"
-#define GAME  "GAME"
+// Server Settings
+#define WORKER_THREADS 0 // event loop threads, 0 = one per core
+#define LISTEN_BACKLOG 4096 // pending connections on the listening socket, capped by net.core.somaxconn
+#define ACCEPT_BURST 256 // connections accepted per wakeup before other sockets get a turn
+#define RECV_BUFFER_SIZE 4096 // per-client cap on received but unprocessed bytes
+#define SEND_HIGH_WATER (256 * 1024) // queued output bytes after which a slow client is dropped
+#define ARENA_FIRST_CHUNK (16 * 1024) // bytes a match's arena first takes from the heap; later chunks grow
+#define ARENA_MAX_BLOCK (64 * 1024) // largest block a match's arena recycles; bigger frames go on the heap
+#define TURN_TIMEOUT 30 // seconds a player has to finish their turn, 0 = no limit
+#define TURN_TIMEOUT_AUTOPLAY 1 // on timeout: 1 = attack the weakest enemy for them, 0 = skip the turn
+#define ROUND_MODE 0 // 1 = every living player chooses at once and the round resolves together, 0 = one turn at a time
+#define STATS_PORT 5051 // metrics over HTTP on 127.0.0.1, 0 = disabled
+#define JOURNAL_DIR "journals" // battle journals for ./replay, "" = disabled
 
 // Messages
 #define WAITING_MSG "Waiting for connections..."
@@ -1,13 +1,128 @@
 #include <iostream>
 
 #include "controller.h"
+#include "characters/classes.h"
 
-// Constructor: initializes controller with player list and sets first turn
-Controller::Controller(const std::vector<Character *> &chars) : players(chars), currentTurn(0) {}
+// One action of a concrete class. Class is final, so the calls are direct.
+template <typename Class>
+static ActionResult perform(Class& c, int action, Rng& rng){
+    switch(action){
+        case ATTACK: return c.attack(rng);
+        case CAST_SPELL: return c.castSpell(rng);
+        case SPECIAL_MOVE: return c.specialMove(rng);
+        default: return c.areaAttack(rng);
+    }
+}
+
+#define AREA_LANES 8 // Players per block of the area pass; a fixed count lets the compiler use SIMD
+
+// What the area pass did to a player
+enum AreaOutcome : int32_t {
+    AREA_MISSED = 0, // Attacker, dead, or out of reach
+    AREA_HIT = 1,
+    AREA_BLOCKED = 2 // Protected: takes no damage and loses the protection
+};
+
+// One player of the area pass, without branches so the compiler can run the lanes side by side
+static inline int32_t strikeLane(int32_t& hp, int32_t protectedTurns, bool self, int32_t damage, int32_t reach){
+    int32_t inReach = (hp > 0) & (hp <= reach) & !self;
+    int32_t blocked = inReach & (protectedTurns != 0);
+    int32_t hit = inReach & !blocked;
+    int32_t left = hp - damage;
+    if(left < 0) left = 0;
+    hp = hit ? left : hp;
+    return hit | (blocked << 1);
+}
+
+// Deals an area action's damage over the flat health and protection columns in one pass, filling
+// in each player's AreaOutcome
+static void areaPass(int32_t *__restrict health, const int32_t *__restrict protectedTurns, int32_t *__restrict outcome,
+                     int count, int self, int32_t damage, int32_t reach, int& hits, int& blocks){
+    int i = 0, hit = 0, blocked = 0;
+    for(; i + AREA_LANES <= count; i += AREA_LANES){
+        for(int lane = 0; lane < AREA_LANES; lane++){
+            int32_t hp = health[i + lane];
+            int32_t o = strikeLane(hp, protectedTurns[i + lane], i + lane == self, damage, reach);
+            health[i + lane] = hp;
+            outcome[i + lane] = o;
+            hit += o & AREA_HIT;
+            blocked += o >> 1;
+        }
+    }
+    for(; i < count; i++){
+        int32_t hp = health[i];
+        int32_t o = strikeLane(hp, protectedTurns[i], i == self, damage, reach);
+        health[i] = hp;
+        outcome[i] = o;
+        hit += o & AREA_HIT;
+        blocked += o >> 1;
+    }
+    hits = hit;
+    blocks = blocked;
+}
+
+// Constructor: links the living players in turn order, starts with the first of them and seeds the battle
+Controller::Controller(const std::vector<Character *> &chars, uint64_t seed)
+    : players(chars), ring(chars.size()), aliveCount(0), currentTurn(0), seed(seed), rng(seed), effects(chars),
+      health(chars.size()), outcome(chars.size())
+{
+    int first = -1, last = -1;
+    for(int i = 0; i < (int)players.size(); i++){
+        players[i]->observeDeath(this, i);
+        health[i] = players[i]->getHealth();
+        ring[i] = Link{i, i, false};
+        if(!players[i]->isAlive()) continue;
+
+        if(first < 0) first = i;
+        else{
+            ring[last].next = i;
+            ring[i].prev = last;
+        }
+        ring[i].linked = true;
+        last = i;
+        aliveCount++;
+    }
+
+    if(first >= 0){
+        ring[last].next = first;
+        ring[first].prev = last;
+        currentTurn = first;
+    }
+}
+
+Controller::~Controller(){
+    for(Character *c : players){
+        if(c->getRosterIndex() >= 0) c->observeDeath(nullptr, -1);
+    }
+}
+
+// Position of c in this battle's roster, or -1 if it is not one of its players
+int Controller::indexOf(Character *c) const{
+    int i = c->getRosterIndex();
+    return i >= 0 && i < (int)players.size() && players[i] == c ? i : -1;
+}
+
+// Unlinks a player whose health reached zero
+void Controller::onDeath(Character *c){
+    int i = indexOf(c);
+    if(i < 0 || !ring[i].linked) return;
+
+    ring[ring[i].prev].next = ring[i].next;
+    ring[ring[i].next].prev = ring[i].prev;
+    ring[i].linked = false;
+    aliveCount--;
+    health[i] = 0;
+    effects.clear(i);
+}
 
-// Advances to the next player's turn
+// Advances to the next living player. Only walks more than one step when the current player and
+// the ones after it died since they were linked.
 void Controller::nextTurn() {
-    currentTurn = (currentTurn + 1) % players.size();
+    if(aliveCount == 0) return;
+
+    int next = ring[currentTurn].next;
+    while(!ring[next].linked) next = ring[next].next;
+    currentTurn = next;
 }
 
 // Returns the current player
@@ -18,47 +133,63 @@ Character* Controller::getCurrentPlayer() {
 // Applies the chosen action from attacker to target and returns result
 ActionResult Controller::applyAction(Character *attacker, int action, Character *target){
     ActionResult result;
-
-    switch(action){
-        case ATTACK: 
-            result = attacker->attack(); break;
-        case CAST_SPELL: 
-            result = attacker->castSpell(); break;
-        case SPECIAL_MOVE: 
-            result = attacker->specialMove(); break;
-        default:
-            result.isError = true;
-            result.message = "Invalid action type.";
-            return result;
+    int attackerIndex = indexOf(attacker);
+    int targetIndex = target ? indexOf(target) : -1;
+    if(attackerIndex < 0 || action < ATTACK || action >= ACTION_COUNT || (action != AREA_ATTACK && targetIndex < 0)){
+        result.error = ERROR_INVALID_ACTION;
+        return result;
     }
 
-    if(!result.isError){
-        if(target->getNextAttackProtected()) {
-            target->handleAttackProtection();
-            target->setNextAttackProtected(false);
+    // Resolved per class at compile time: a switch on the class, then direct calls
+    result = dispatchClass(*attacker, [&](auto& c){ return perform(c, action, rng); });
+
+    if(!result.isError()){
+        if(action == AREA_ATTACK){
+            strikeArea(attackerIndex, result);
+        }
+        else if(target->getNextAttackProtected()) {
+            result.blocked = dispatchClass(*target, [](auto& c){ return c.handleAttackProtection(); });
+            effects.consume(targetIndex, EFFECT_PROTECTED);
         } 
         else{
             target->takeDamage(result.damage);
-        }
-        
-        int temporaryAttack[2] = {attacker->getTemporaryAttackBonusValue(), attacker->getTemporaryAttackBonusDuration()};
-        if(temporaryAttack[0] > 0){
-            attacker->setTemporaryAttackBonus(temporaryAttack[0], temporaryAttack[1]--);
-        }
-        else{
-            attacker->setTemporaryAttackBonus(0, 0);
+            health[targetIndex] = target->getHealth();
         }
 
-        if(result.heal > 0) attacker->gainHealth(result.heal);
+        // Effects the attacker already had lose one action; the one it just earned starts now
+        effects.endTurn(attackerIndex, result);
+
+        if(result.heal > 0){
+            attacker->gainHealth(result.heal);
+            health[attackerIndex] = attacker->getHealth();
+        }
     }
 
     return result;
 }
 
+// Resolves an area action in one vectorized pass over the health and protection columns, then
+// brings only the players it reached up to date: the hit take the damage (and may die), the
+// protected lose their protection
+void Controller::strikeArea(int attackerIndex, ActionResult& result){
+    int count = (int)players.size();
+    areaPass(health.data(), effects.turnsLeft(EFFECT_PROTECTED), outcome.data(), count, attackerIndex,
+             result.damage, result.reach, result.hits, result.blocks);
+    if(result.hits == 0 && result.blocks == 0) return;
+
+    for(int i = 0; i < count; i++){
+        if(outcome[i] == AREA_HIT){
+            players[i]->takeDamage(result.damage);
+            if(!players[i]->isAlive()) result.kills++;
+        }
+        else if(outcome[i] == AREA_BLOCKED){
+            effects.consume(i, EFFECT_PROTECTED);
+        }
+    }
+}
+
 // Returns true if only one or no players are alive
 bool Controller::isBattleOver() {
-    int aliveCount = 0;
-    for(auto c : players) if (c->isAlive()) aliveCount++;
     return aliveCount <= 1;
 }
 
@@ -3,22 +3,59 @@
 
 #include <vector>
 #include "characters/character.h"
+#include "effects.h"
+#include "rng.h"
 
-class Controller {
+// Runs one battle. Living players are linked in a ring in turn order, and a counter tracks how
+// many are left; both update when a character dies (it notifies the controller), so finding the
+// next player and checking for the end of the battle are O(1) however many players have died.
+class Controller final : private DeathObserver {
     private:
+        // Ring of living players by index in players. A player that dies is unlinked but keeps its
+        // next, so the turn can still move on from it.
+        struct Link {
+            int prev;
+            int next;
+            bool linked;
+        };
+
         std::vector<Character *> players; // List of player characters
+        std::vector<Link> ring;
+        int aliveCount;
         int currentTurn;                  // Index of the current player's turn
+        uint64_t seed;                    // Seed the battle was started with
+        Rng rng;                          // Source of every random outcome in this battle
+        EffectTable effects;              // Buffs and protections in play
+
+        // Every player's health by roster index, kept in step with the characters by the controller,
+        // so area actions scan one flat array instead of visiting each character
+        std::vector<int32_t> health;
+        std::vector<int32_t> outcome; // Scratch of strikeArea: what the pass did to each player
+
+        void onDeath(Character *c) override;
+        int indexOf(Character *c) const;
+        void strikeArea(int attackerIndex, ActionResult& result);
 
     public:
-        Controller(const std::vector<Character*>& chars); 
+        Controller(const std::vector<Character*>& chars, uint64_t seed); 
+        ~Controller();
+
+        Controller(const Controller&) = delete;
+        Controller& operator=(const Controller&) = delete;
 
         void nextTurn();                                  
 
         Character* getCurrentPlayer();                   
 
+        // Both characters must be players of this battle. AREA_ATTACK takes no target (nullptr) and
+        // hits every enemy in reach.
         ActionResult applyAction(Character *attacker, int action, Character *target); 
 
         bool isBattleOver();                              
+        int getAliveCount() const { return aliveCount; }
+
+        uint64_t getSeed() const { return seed; }
+        Rng& getRng() { return rng; }
 };
 
 #endif
@@ -0,0 +1,81 @@
+#include "effects.h"
+
+StackRule stackRule(EffectType type){
+    switch(type){
+        case EFFECT_ATTACK_BONUS: return STACK_REPLACE; // A new bonus overrides the last one
+        case EFFECT_PROTECTED: return STACK_REFRESH;    // Protected or not, it does not add up
+        default: return STACK_ADD;
+    }
+}
+
+// Longer of two durations, where EFFECT_UNTIL_CONSUMED outlasts any number of actions
+static int32_t longer(int32_t a, int32_t b){
+    if(a == EFFECT_UNTIL_CONSUMED || b == EFFECT_UNTIL_CONSUMED) return EFFECT_UNTIL_CONSUMED;
+    return a > b ? a : b;
+}
+
+EffectTable::EffectTable(const std::vector<Character *>& players) : players(players) {
+    for(int type = EFFECT_NONE + 1; type < EFFECT_TYPE_COUNT; type++){
+        columns[type].values.assign(players.size(), 0);
+        columns[type].turnsLeft.assign(players.size(), 0);
+    }
+}
+
+// Writes a player's totals back to the character
+void EffectTable::publish(int player){
+    const Column& bonus = columns[EFFECT_ATTACK_BONUS];
+    Character *c = players[player];
+    c->setAttackBonus(bonus.turnsLeft[player] != 0 ? bonus.values[player] : 0);
+    c->setNextAttackProtected(columns[EFFECT_PROTECTED].turnsLeft[player] != 0);
+}
+
+void EffectTable::grant(int player, EffectType type, int value, int turns){
+    if(type == EFFECT_NONE || turns == 0) return;
+
+    int32_t& current = columns[type].values[player];
+    int32_t& left = columns[type].turnsLeft[player];
+
+    if(left == 0 || stackRule(type) == STACK_REPLACE){
+        current = value;
+        left = turns;
+    }
+    else if(stackRule(type) == STACK_ADD){
+        current += value;
+        left = longer(left, turns);
+    }
+    else{
+        if(value > current) current = value;
+        left = longer(left, turns);
+    }
+    publish(player);
+}
+
+void EffectTable::endTurn(int player, const ActionResult& result){
+    bool expired = false;
+    for(int type = EFFECT_NONE + 1; type < EFFECT_TYPE_COUNT; type++){
+        int32_t& left = columns[type].turnsLeft[player];
+        if(left > 0 && --left == 0){
+            columns[type].values[player] = 0;
+            expired = true;
+        }
+    }
+
+    if(result.effect != EFFECT_NONE) grant(player, (EffectType)result.effect, result.effectValue, result.effectTurns);
+    else if(expired) publish(player);
+}
+
+void EffectTable::consume(int player, EffectType type){
+    if(columns[type].turnsLeft[player] == 0) return;
+
+    columns[type].turnsLeft[player] = 0;
+    columns[type].values[player] = 0;
+    publish(player);
+}
+
+void EffectTable::clear(int player){
+    for(int type = EFFECT_NONE + 1; type < EFFECT_TYPE_COUNT; type++){
+        columns[type].turnsLeft[player] = 0;
+        columns[type].values[player] = 0;
+    }
+    publish(player);
+}
@@ -0,0 +1,56 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "characters/character.h"
+
+// How a new effect combines with one of the same type its owner already has
+enum StackRule : uint8_t {
+    STACK_REPLACE, // The new effect takes the old one's place
+    STACK_ADD,     // Values add up and the longer duration is kept
+    STACK_REFRESH  // The larger value and the longer duration are kept
+};
+
+StackRule stackRule(EffectType type);
+
+// Status effects of one battle as a column per effect type with a row per player (the index in
+// the battle's roster). A player's effects are found by index, ticking them costs one step per
+// type, and going over every active effect is a linear pass over flat arrays, however many
+// overlap. Each player's totals are written back to its Character (attack bonus, protection),
+// which is what the rules and the state frames read.
+class EffectTable {
+    private:
+        struct Column {
+            std::vector<int32_t> values;
+            std::vector<int32_t> turnsLeft; // Owner's actions left: 0 = inactive, EFFECT_UNTIL_CONSUMED = no limit
+        };
+
+        std::vector<Character *> players;
+        Column columns[EFFECT_TYPE_COUNT]; // EFFECT_NONE's column stays empty
+
+        void publish(int player);
+
+    public:
+        explicit EffectTable(const std::vector<Character *>& players);
+
+        // Gives a player an effect that lasts their next `turns` actions
+        void grant(int player, EffectType type, int value, int turns);
+
+        // Called after a player acted: their timed effects lose one action and those that ran out
+        // end, then the effect the action granted, if any, starts
+        void endTurn(int player, const ActionResult& result);
+
+        // Ends a player's effect of one type, e.g. a protection that just blocked an attack
+        void consume(int player, EffectType type);
+
+        // Ends every effect a player has
+        void clear(int player);
+
+        // Actions left on every player's effect of one type, by roster index (0 = none), for passes
+        // over the whole battle
+        const int32_t* turnsLeft(EffectType type) const { return columns[type].turnsLeft.data(); }
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include <cstdlib>
+#include <new>
+
+#include "metrics.h"
+
+// Replacements for the global allocation functions that count each thread's heap calls, so the
+// stats show how often a worker's turns reach the heap. Array and nothrow new forward to these in
+// libstdc++; aligned new is not counted.
+
+static thread_local Counter *heapCalls = nullptr;
+
+void countHeapCalls(Counter *counter){
+    heapCalls = counter;
+}
+
+void* operator new(std::size_t size){
+    if(heapCalls) heapCalls->add();
+    if(size == 0) size = 1;
+
+    while(true){
+        void *p = std::malloc(size);
+        if(p) return p;
+
+        std::new_handler handler = std::get_new_handler();
+        if(!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
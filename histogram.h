@@ -0,0 +1,98 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Log-linear latency histogram in the style of HdrHistogram. Values below 2^HISTOGRAM_SUB_BITS
+// get one bucket each; above that every power of two is split into 2^(HISTOGRAM_SUB_BITS-1)
+// equal buckets, so any recorded value is reported within about 3% (with 6 sub bits). Recording is
+// a couple of shifts and an increment, and the whole uint64_t range fits in under 2000 buckets.
+
+#define HISTOGRAM_SUB_BITS 6
+
+class Histogram {
+    private:
+        static const uint64_t SUB = 1ull << HISTOGRAM_SUB_BITS;
+        static const uint64_t HALF = SUB / 2;
+
+        std::vector<uint64_t> buckets;
+        uint64_t total;
+        uint64_t sum;
+        uint64_t minValue;
+        uint64_t maxValue;
+
+    public:
+        static const size_t BUCKETS = (64 - HISTOGRAM_SUB_BITS + 1) * HALF + HALF;
+
+        Histogram() : buckets(BUCKETS, 0), total(0), sum(0), minValue(UINT64_MAX), maxValue(0) {}
+
+        static size_t bucketOf(uint64_t value){
+            if(value < SUB) return (size_t)value;
+            int shift = 63 - __builtin_clzll(value) - HISTOGRAM_SUB_BITS + 1;
+            return (size_t)(shift * HALF + (value >> shift));
+        }
+
+        // Largest value that lands in bucket index
+        static uint64_t bucketValue(size_t index){
+            if(index < SUB) return index;
+            uint64_t shift = index / HALF - 1;
+            uint64_t mantissa = index - shift * HALF;
+            return ((mantissa + 1) << shift) - 1;
+        }
+
+        void record(uint64_t value){
+            buckets[bucketOf(value)]++;
+            total++;
+            sum += value;
+            minValue = std::min(minValue, value);
+            maxValue = std::max(maxValue, value);
+        }
+
+        // Adds n samples valued like bucket index, for histograms copied from bucket counts
+        void addToBucket(size_t index, uint64_t n){
+            uint64_t value = bucketValue(index);
+            buckets[index] += n;
+            total += n;
+            sum += value * n;
+            minValue = std::min(minValue, value);
+            maxValue = std::max(maxValue, value);
+        }
+
+        void merge(const Histogram& other){
+            for(size_t i = 0; i < BUCKETS; i++) buckets[i] += other.buckets[i];
+            total += other.total;
+            sum += other.sum;
+            minValue = std::min(minValue, other.minValue);
+            maxValue = std::max(maxValue, other.maxValue);
+        }
+
+        void reset(){
+            std::fill(buckets.begin(), buckets.end(), 0);
+            total = sum = maxValue = 0;
+            minValue = UINT64_MAX;
+        }
+
+        uint64_t count() const { return total; }
+        uint64_t min() const { return total ? minValue : 0; }
+        uint64_t max() const { return maxValue; }
+        double mean() const { return total ? (double)sum / total : 0; }
+
+        // Smallest bucket value v such that at least p (0..1) of the samples are <= v
+        uint64_t percentile(double p) const {
+            if(total == 0) return 0;
+
+            uint64_t needed = (uint64_t)(p * total + 0.5);
+            if(needed == 0) needed = 1;
+
+            uint64_t seen = 0;
+            for(size_t i = 0; i < BUCKETS; i++){
+                seen += buckets[i];
+                if(seen >= needed) return std::min(bucketValue(i), maxValue);
+            }
+            return maxValue;
+        }
+};
+
+#endif
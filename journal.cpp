@@ -0,0 +1,296 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include "journal.h"
+
+// Little-endian encoding helpers
+static void put8(std::string& out, uint8_t v){
+    out.push_back((char)v);
+}
+
+static void put16(std::string& out, uint16_t v){
+    char b[2] = {(char)v, (char)(v >> 8)};
+    out.append(b, 2);
+}
+
+static void put32(std::string& out, uint32_t v){
+    char b[4] = {(char)v, (char)(v >> 8), (char)(v >> 16), (char)(v >> 24)};
+    out.append(b, 4);
+}
+
+static void put64(std::string& out, uint64_t v){
+    put32(out, (uint32_t)v);
+    put32(out, (uint32_t)(v >> 32));
+}
+
+static uint16_t get16(const unsigned char *p){
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t get32(const unsigned char *p){
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t get64(const unsigned char *p){
+    return (uint64_t)get32(p) | (uint64_t)get32(p + 4) << 32;
+}
+
+// Size of each record body, indexed by record type
+static size_t recordSize(uint8_t type){
+    switch(type){
+        case JOURNAL_TURN: return 4 + 4 + 1 + 1 + 4 + 4;
+        case JOURNAL_DISCONNECT: return 4;
+        case JOURNAL_END: return 4 + 4;
+        default: return 0;
+    }
+}
+
+// Constructor: creates the directory if needed and starts the writer thread
+JournalSink::JournalSink(const std::string& directory) : directory(directory), stopping(false) {
+    if(mkdir(directory.c_str(), 0755) < 0 && errno != EEXIST) perror("mkdir journal directory failed");
+
+    char stamp[32];
+    time_t now = time(nullptr);
+    struct tm utc;
+    gmtime_r(&now, &utc);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &utc);
+    runTag = std::string(stamp) + "-" + std::to_string(getpid());
+    writer = std::thread([this](){ run(); });
+}
+
+JournalSink::~JournalSink(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready.notify_one();
+    if(writer.joinable()) writer.join();
+
+    for(auto& file : files) if(file.second >= 0) close(file.second);
+}
+
+std::string JournalSink::pathFor(const std::string& name) const {
+    return directory + "/" + runTag + "-" + name;
+}
+
+// Queues a chunk; the only time a match touches the lock
+void JournalSink::submit(const std::string& path, std::string bytes, bool last){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(Chunk{path, std::move(bytes), last});
+    }
+    ready.notify_one();
+}
+
+void JournalSink::run(){
+    while(true){
+        std::deque<Chunk> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this](){ return stopping || !queue.empty(); });
+            if(queue.empty() && stopping) return;
+            batch.swap(queue);
+        }
+
+        for(const Chunk& chunk : batch) writeChunk(chunk);
+    }
+}
+
+// Appends a chunk to its file, creating the file on its first chunk. A file that already exists
+// is never written to, so one journal can only ever hold one battle.
+void JournalSink::writeChunk(const Chunk& chunk){
+    auto it = files.find(chunk.path);
+    if(it == files.end()){
+        int fd = ::open(chunk.path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0644);
+        if(fd < 0) perror(("open journal " + chunk.path + " failed").c_str());
+        it = files.emplace(chunk.path, fd).first; // -1 drops the journal's later chunks quietly
+    }
+
+    const char *data = chunk.bytes.data();
+    size_t left = it->second >= 0 ? chunk.bytes.size() : 0;
+    while(left > 0){
+        ssize_t n = write(it->second, data, left);
+        if(n < 0){
+            if(errno == EINTR) continue;
+            perror("journal write failed");
+            break;
+        }
+        data += n;
+        left -= (size_t)n;
+    }
+
+    if(chunk.last){
+        if(it->second >= 0) close(it->second);
+        files.erase(it);
+    }
+}
+
+// Constructor: nothing is written until begin()
+JournalWriter::JournalWriter(JournalSink& sink, const std::string& path)
+    : sink(sink), path(path), turns(0), ended(false) {
+    buffer.reserve(JOURNAL_FLUSH_BYTES);
+}
+
+JournalWriter::~JournalWriter(){
+    if(!ended) end(-1);
+}
+
+void JournalWriter::flush(bool last){
+    if(buffer.empty() && !last) return;
+
+    std::string chunk;
+    chunk.reserve(JOURNAL_FLUSH_BYTES);
+    chunk.swap(buffer);
+    sink.submit(path, std::move(chunk), last);
+}
+
+// Writes the header: seed and roster in turn order
+void JournalWriter::begin(uint64_t seed, const std::vector<Character *>& players){
+    buffer.append(JOURNAL_MAGIC, 4);
+    put16(buffer, JOURNAL_VERSION);
+    put16(buffer, 0);
+    put64(buffer, seed);
+    put32(buffer, (uint32_t)players.size());
+
+    for(Character *c : players){
+        ClassId classId = c->getClassId();
+        std::string name = c->getName();
+        if(name.size() > 0xFFFF) name.resize(0xFFFF);
+
+        put8(buffer, (uint8_t)classId);
+        put16(buffer, (uint16_t)name.size());
+        buffer += name;
+    }
+}
+
+void JournalWriter::recordTurn(uint32_t attacker, int action, uint32_t target, const ActionResult& result){
+    put8(buffer, JOURNAL_TURN);
+    put32(buffer, attacker);
+    put32(buffer, target);
+    put8(buffer, (uint8_t)action);
+    put8(buffer, result.isError() ? JOURNAL_FLAG_ERROR : 0);
+    put32(buffer, (uint32_t)result.damage);
+    put32(buffer, (uint32_t)result.heal);
+    turns++;
+
+    if(buffer.size() >= JOURNAL_FLUSH_BYTES) flush(false);
+}
+
+void JournalWriter::recordDisconnect(uint32_t player){
+    put8(buffer, JOURNAL_DISCONNECT);
+    put32(buffer, player);
+
+    if(buffer.size() >= JOURNAL_FLUSH_BYTES) flush(false);
+}
+
+void JournalWriter::end(int winner){
+    if(ended) return;
+
+    put8(buffer, JOURNAL_END);
+    put32(buffer, (uint32_t)winner);
+    put32(buffer, turns);
+
+    ended = true;
+    flush(true);
+}
+
+JournalReader::JournalReader() : data(nullptr), size(0), pos(0), seed(0) {}
+
+JournalReader::~JournalReader(){
+    if(data) munmap((void *)data, size);
+}
+
+bool JournalReader::open(const std::string& path, std::string& error){
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0){
+        error = strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) < 0 || st.st_size < 20){
+        close(fd);
+        error = "file too small to be a journal";
+        return false;
+    }
+
+    size = (size_t)st.st_size;
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapped == MAP_FAILED){
+        size = 0;
+        error = strerror(errno);
+        return false;
+    }
+    data = (const unsigned char *)mapped;
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    if(memcmp(data, JOURNAL_MAGIC, 4) != 0){
+        error = "bad magic";
+        return false;
+    }
+    if(get16(data + 4) != JOURNAL_VERSION){
+        error = "unsupported journal version " + std::to_string(get16(data + 4));
+        return false;
+    }
+
+    seed = get64(data + 8);
+    uint32_t count = get32(data + 16);
+    pos = 20;
+
+    players.clear();
+    for(uint32_t i = 0; i < count; i++){
+        if(size - pos < 3){
+            error = "truncated roster";
+            return false;
+        }
+        uint8_t classId = data[pos];
+        uint16_t length = get16(data + pos + 1);
+        pos += 3;
+
+        if(classId >= CLASS_COUNT || size - pos < length){
+            error = "corrupt roster entry";
+            return false;
+        }
+        players.push_back(JournalPlayer{(ClassId)classId, std::string((const char *)data + pos, length)});
+        pos += length;
+    }
+    return true;
+}
+
+bool JournalReader::next(JournalRecord& record){
+    if(pos >= size) return false;
+
+    uint8_t type = data[pos];
+    size_t body = recordSize(type);
+    if(body == 0 || size - pos - 1 < body) return false;
+
+    const unsigned char *p = data + pos + 1;
+    record = JournalRecord();
+    record.type = type;
+
+    if(type == JOURNAL_TURN){
+        record.attacker = get32(p);
+        record.target = get32(p + 4);
+        record.action = p[8];
+        record.flags = p[9];
+        record.damage = (int32_t)get32(p + 10);
+        record.heal = (int32_t)get32(p + 14);
+    }
+    else if(type == JOURNAL_DISCONNECT){
+        record.attacker = get32(p);
+    }
+    else{
+        record.winner = (int32_t)get32(p);
+        record.turns = get32(p + 4);
+    }
+
+    pos += 1 + body;
+    return true;
+}
@@ -0,0 +1,150 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "characters/character.h"
+#include "characters/factory.h"
+
+// Append-only binary match journal.
+//
+// File layout (all integers little-endian):
+//   header:  "NRPJ" | u16 version | u16 reserved | u64 seed | u32 player count
+//            then per player: u8 class id | u16 name length | name bytes
+//   records: u8 type followed by a fixed-size body
+//     JOURNAL_TURN        u32 attacker | u32 target | u8 action | u8 flags | i32 damage | i32 heal
+//                         (target is JOURNAL_NO_TARGET for area actions, damage is per enemy hit)
+//     JOURNAL_DISCONNECT  u32 player
+//     JOURNAL_END         i32 winner (-1 = none) | u32 turns
+//
+// Player numbers are positions in the header roster, which is the Controller's turn order.
+
+#define JOURNAL_MAGIC "NRPJ"
+#define JOURNAL_VERSION 2 // Bumped when the rules change, since older journals no longer replay the same
+#define JOURNAL_NO_TARGET 0xFFFFFFFFu
+#define JOURNAL_FLUSH_BYTES (64 * 1024) // Buffered bytes per match before a chunk is handed off
+
+enum JournalRecordType : uint8_t {
+    JOURNAL_TURN = 1,
+    JOURNAL_DISCONNECT = 2,
+    JOURNAL_END = 3
+};
+
+// Flags of a JOURNAL_TURN record
+enum JournalTurnFlags : uint8_t {
+    JOURNAL_FLAG_ERROR = 1
+};
+
+// Background thread that owns every journal file. Matches hand it whole chunks, so the turn loop
+// only ever appends to memory and never waits on the disk.
+class JournalSink {
+    private:
+        struct Chunk {
+            std::string path;
+            std::string bytes;
+            bool last; // Close the file after writing
+        };
+
+        std::string directory;
+        std::string runTag; // Start time and pid of this server run, prefixed to every file name
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<Chunk> queue;
+        bool stopping;
+        std::unordered_map<std::string, int> files; // Open fds, only touched by the writer thread
+        std::thread writer;
+
+        void run();
+        void writeChunk(const Chunk& chunk);
+
+    public:
+        explicit JournalSink(const std::string& directory);
+        ~JournalSink(); // Writes everything still queued
+
+        JournalSink(const JournalSink&) = delete;
+        JournalSink& operator=(const JournalSink&) = delete;
+
+        // Full path of a journal file inside the sink's directory. Names are prefixed with the run,
+        // so a restarted server never reuses an older run's file.
+        std::string pathFor(const std::string& name) const;
+
+        void submit(const std::string& path, std::string bytes, bool last);
+};
+
+// Per-match journal. Records are encoded into an in-memory buffer that is handed to the sink in
+// JOURNAL_FLUSH_BYTES chunks.
+class JournalWriter {
+    private:
+        JournalSink& sink;
+        std::string path;
+        std::string buffer;
+        uint32_t turns;
+        bool ended;
+
+        void flush(bool last);
+
+    public:
+        JournalWriter(JournalSink& sink, const std::string& path);
+        ~JournalWriter(); // Ends the journal if end() was never called
+
+        JournalWriter(const JournalWriter&) = delete;
+        JournalWriter& operator=(const JournalWriter&) = delete;
+
+        void begin(uint64_t seed, const std::vector<Character *>& players);
+        void recordTurn(uint32_t attacker, int action, uint32_t target, const ActionResult& result);
+        void recordDisconnect(uint32_t player);
+        void end(int winner);
+};
+
+// Decoded journal header
+struct JournalPlayer {
+    ClassId classId;
+    std::string name;
+};
+
+struct JournalRecord {
+    uint8_t type = 0;
+    uint32_t attacker = 0; // Also the player of a JOURNAL_DISCONNECT
+    uint32_t target = 0;
+    uint8_t action = 0;
+    uint8_t flags = 0;
+    int32_t damage = 0;
+    int32_t heal = 0;
+    int32_t winner = -1;
+    uint32_t turns = 0;
+};
+
+// Read-only view of a journal file through mmap
+class JournalReader {
+    private:
+        const unsigned char *data;
+        size_t size;
+        size_t pos; // Next record
+
+    public:
+        uint64_t seed;
+        std::vector<JournalPlayer> players;
+
+        JournalReader();
+        ~JournalReader();
+
+        JournalReader(const JournalReader&) = delete;
+        JournalReader& operator=(const JournalReader&) = delete;
+
+        // Maps the file and parses the header; error explains a false return
+        bool open(const std::string& path, std::string& error);
+
+        // Decodes the next record. Returns false at the end of the file or on a truncated or
+        // unknown record, which atEnd tells apart.
+        bool next(JournalRecord& record);
+        bool atEnd() const { return pos == size; }
+};
+
+#endif
@@ -0,0 +1,483 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "constants.h"
+#include "histogram.h"
+#include "protocol.h"
+#include "reactor.h"
+#include "recvbuffer.h"
+#include "rng.h"
+#include "sendqueue.h"
+
+// Load generator: thousands of bot players driven from one epoll loop. Every bot joins a lobby,
+// configures an avatar and answers its action and target prompts at once, reconnecting when its
+// match ends, until the run is over. Latencies are measured on the bot side.
+
+#define BOT_RECV_BUFFER_SIZE (64 * 1024)
+#define RAMP_TICK_MS 10
+#define BOT_AREA_ACTION 3 // AREA_ATTACK: hits every enemy in reach and takes no target
+
+static const char* BOT_CLASSES[] = {"Orc", "Mage", "Halfling"};
+
+struct LoadConfig {
+    std::string host = "127.0.0.1";
+    int port = PORT;
+    int clients = 1000;   // Concurrent connections to keep open
+    int rate = 1000;      // New connections per second
+    int duration = 30;    // Seconds
+    bool combined = false; // Answer the action prompt with the action and the target in one request
+    int area = 0;          // Percent of actions that are area attacks
+    bool ahead = false;    // Send the next combined order along with each answer, before its prompt
+};
+
+enum class BotState {
+    IDLE,       // No connection
+    CONNECTING, // Non-blocking connect in progress
+    CONNECTED
+};
+
+// What the bot is waiting on, to time the round trip
+enum class Awaiting {
+    NOTHING,
+    TARGET_PROMPT, // Sent an action, waiting for the target list
+    RESULT         // Sent a target, waiting for the action result
+};
+
+struct Bot {
+    int id;
+    int fd = -1;
+    BotState state = BotState::IDLE;
+    RecvBuffer inbox;
+    SendQueue outbox;
+    uint64_t started = 0;     // Connect or request time, microseconds
+    Awaiting awaiting = Awaiting::NOTHING;
+    bool writable = true;     // False while EPOLLOUT is armed
+
+    // Roster kept from MSG_SNAPSHOT and MSG_DELTA, enough to pick a living target
+    std::vector<uint8_t> alive;
+    uint32_t self = NO_PLAYER;
+    uint32_t seq = 0;
+    bool haveSnapshot = false;
+
+    explicit Bot(int id) : id(id), inbox(BOT_RECV_BUFFER_SIZE) {}
+};
+
+static uint64_t nowMicros(){
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class LoadGenerator {
+    private:
+        LoadConfig config;
+        Reactor reactor;
+        sockaddr_in address;
+        Rng rng;
+        std::vector<std::unique_ptr<Bot>> bots;
+        bool running;
+
+        int connecting, connected;
+        uint64_t connectFailures, disconnects, sessions;
+        uint64_t turns, frames, bytes, resyncs;
+        uint64_t lastTurns;
+        Histogram connectLatency, actionRtt, turnRtt;
+
+        void connectBot(Bot& bot);
+        void closeBot(Bot& bot);
+        void send(Bot& bot, std::string frame);
+        void onEvent(Bot& bot, uint32_t events);
+        void onConnected(Bot& bot);
+        bool handleFrame(Bot& bot, const Frame& frame);
+        void applyState(Bot& bot, const Frame& frame);
+        void chooseTarget(Bot& bot, int32_t action = -1, bool timed = true);
+        void rampUp();
+        void progress(int elapsed);
+
+    public:
+        explicit LoadGenerator(const LoadConfig& config);
+        bool run();
+        void report(double seconds);
+};
+
+LoadGenerator::LoadGenerator(const LoadConfig& config)
+    : config(config), rng(nowMicros()), running(true), connecting(0), connected(0),
+      connectFailures(0), disconnects(0), sessions(0), turns(0), frames(0), bytes(0), resyncs(0), lastTurns(0) {
+    address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(config.port);
+
+    for(int i = 0; i < config.clients; i++) bots.emplace_back(new Bot(i));
+}
+
+// Starts a non-blocking connect; completion is reported by EPOLLOUT
+void LoadGenerator::connectBot(Bot& bot){
+    bot.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(bot.fd < 0){
+        perror("socket failed");
+        return;
+    }
+
+    int one = 1;
+    setsockopt(bot.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    bot.started = nowMicros();
+    if(connect(bot.fd, (sockaddr *)&address, sizeof(address)) < 0 && errno != EINPROGRESS){
+        connectFailures++;
+        close(bot.fd);
+        bot.fd = -1;
+        return;
+    }
+
+    bot.state = BotState::CONNECTING;
+    connecting++;
+    reactor.add(bot.fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP, [this, &bot](uint32_t events){ onEvent(bot, events); });
+}
+
+void LoadGenerator::closeBot(Bot& bot){
+    if(bot.fd < 0) return;
+
+    if(bot.state == BotState::CONNECTING) connecting--;
+    else if(bot.state == BotState::CONNECTED) connected--;
+
+    reactor.remove(bot.fd);
+    close(bot.fd);
+    bot.fd = -1;
+    bot.state = BotState::IDLE;
+    bot.inbox.clear();
+    bot.outbox.clear();
+    bot.awaiting = Awaiting::NOTHING;
+    bot.writable = true;
+    bot.alive.clear();
+    bot.self = NO_PLAYER;
+    bot.haveSnapshot = false;
+}
+
+// Queues a frame and writes what the socket accepts; the rest waits for EPOLLOUT
+void LoadGenerator::send(Bot& bot, std::string frame){
+    bot.outbox.push(makePayload(frame));
+
+    FlushStatus status = bot.outbox.flush(bot.fd);
+    if(status == FLUSH_ERROR) closeBot(bot);
+    else if(status == FLUSH_PENDING && bot.writable){
+        bot.writable = false;
+        reactor.modify(bot.fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP);
+    }
+}
+
+void LoadGenerator::onConnected(Bot& bot){
+    int error = 0;
+    socklen_t length = sizeof(error);
+    getsockopt(bot.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+    if(error != 0){
+        connectFailures++;
+        closeBot(bot);
+        return;
+    }
+
+    connectLatency.record(nowMicros() - bot.started);
+    connecting--;
+    connected++;
+    bot.state = BotState::CONNECTED;
+    reactor.modify(bot.fd, EPOLLIN | EPOLLRDHUP);
+}
+
+void LoadGenerator::onEvent(Bot& bot, uint32_t events){
+    if(bot.state == BotState::CONNECTING){
+        if(!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) return;
+        onConnected(bot);
+        if(bot.state != BotState::CONNECTED) return;
+    }
+    else if(events & EPOLLOUT){
+        FlushStatus status = bot.outbox.flush(bot.fd);
+        if(status == FLUSH_ERROR){
+            closeBot(bot);
+            return;
+        }
+        if(status == FLUSH_DONE){
+            bot.writable = true;
+            reactor.modify(bot.fd, EPOLLIN | EPOLLRDHUP);
+        }
+    }
+
+    if(!(events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) return;
+
+    size_t before = bot.inbox.size();
+    FillStatus fill = bot.inbox.fill(bot.fd);
+    if(fill != FILL_OK){
+        disconnects++;
+        closeBot(bot);
+        return;
+    }
+    bytes += bot.inbox.size() - before;
+
+    Frame frame;
+    DecodeStatus status;
+    while((status = bot.inbox.nextFrame(frame)) == DECODE_OK){
+        frames++;
+        if(!handleFrame(bot, frame)) return;
+    }
+    if(status == DECODE_MALFORMED){
+        std::cerr << "Bot " << bot.id << " received a malformed frame\n";
+        closeBot(bot);
+    }
+}
+
+// Plays one frame. Returns false once the bot's connection is closed.
+bool LoadGenerator::handleFrame(Bot& bot, const Frame& frame){
+    std::string out;
+
+    switch(frame.type){
+        case MSG_PROMPT: {
+            PromptMessage prompt;
+            if(!decodePrompt(frame, prompt)) break;
+
+            if(prompt.kind == PROMPT_AVATAR){
+                encodeInput(out, "Bot" + std::to_string(bot.id) + " " + BOT_CLASSES[rng.below(3)]);
+                send(bot, std::move(out));
+            }
+            else if(prompt.kind == PROMPT_ACTION && config.area > 0 && (int)rng.below(100) < config.area){
+                // Complete on its own: the result comes back without a target prompt
+                ActionRequestMessage request;
+                request.action = BOT_AREA_ACTION;
+                encodeActionRequest(out, request);
+                bot.started = nowMicros();
+                bot.awaiting = Awaiting::RESULT;
+                send(bot, std::move(out));
+            }
+            else if(prompt.kind == PROMPT_ACTION && (config.combined || config.ahead)){
+                chooseTarget(bot, (int32_t)rng.below(3));
+                // Waits in the server's queue and answers the next prompt before it is sent
+                if(config.ahead) chooseTarget(bot, (int32_t)rng.below(3), false);
+            }
+            else if(prompt.kind == PROMPT_ACTION){
+                ActionRequestMessage request;
+                request.action = (int32_t)rng.below(3);
+                encodeActionRequest(out, request);
+                bot.started = nowMicros();
+                bot.awaiting = Awaiting::TARGET_PROMPT;
+                send(bot, std::move(out));
+            }
+            else if(prompt.kind == PROMPT_TARGET){
+                if(bot.awaiting == Awaiting::TARGET_PROMPT) actionRtt.record(nowMicros() - bot.started);
+                bot.awaiting = Awaiting::NOTHING;
+                chooseTarget(bot);
+            }
+            break;
+        }
+
+        case MSG_SNAPSHOT:
+        case MSG_DELTA:
+            applyState(bot, frame);
+            break;
+
+        case MSG_ACTION_RESULT:
+            if(bot.awaiting == Awaiting::RESULT){
+                turnRtt.record(nowMicros() - bot.started);
+                turns++;
+                bot.awaiting = Awaiting::NOTHING;
+            }
+            break;
+
+        case MSG_SHUTDOWN:
+            sessions++;
+            closeBot(bot);
+            return false;
+    }
+
+    return bot.fd >= 0;
+}
+
+// Tracks who is alive. A delta that does not follow the last known state asks for a snapshot.
+void LoadGenerator::applyState(Bot& bot, const Frame& frame){
+    FrameReader r(frame);
+    uint32_t count;
+    PlayerState player;
+
+    if(frame.type == MSG_SNAPSHOT){
+        if(!decodeSnapshotHeader(r, bot.seq, bot.self, count)) return;
+        bot.alive.assign(count, 0);
+        for(uint32_t i = 0; i < count && decodeSnapshotEntry(r, player); i++){
+            if(player.index < count) bot.alive[player.index] = (player.flags & PLAYER_ALIVE) != 0;
+        }
+        bot.haveSnapshot = true;
+        return;
+    }
+
+    uint32_t seq;
+    if(!decodeDeltaHeader(r, seq, count)) return;
+    if(!bot.haveSnapshot) return; // Resync already requested
+    if(seq != bot.seq + 1){
+        std::string out;
+        encodeResync(out);
+        bot.haveSnapshot = false;
+        resyncs++;
+        send(bot, std::move(out));
+        return;
+    }
+    bot.seq = seq;
+
+    uint8_t fields;
+    for(uint32_t i = 0; i < count && decodeDeltaEntry(r, fields, player); i++){
+        if(player.index < bot.alive.size() && (fields & FIELD_FLAGS)) bot.alive[player.index] = (player.flags & PLAYER_ALIVE) != 0;
+    }
+}
+
+// Uniform pick among the living opponents of the local roster, sent with the action when one is given.
+// An untimed pick leaves the round trip being measured alone.
+void LoadGenerator::chooseTarget(Bot& bot, int32_t action, bool timed){
+    uint32_t candidates = 0;
+    for(uint32_t i = 0; i < bot.alive.size(); i++) if(bot.alive[i] && i != bot.self) candidates++;
+    if(candidates == 0) return;
+
+    uint32_t pick = rng.below(candidates);
+    uint32_t target = 0;
+    for(uint32_t i = 0; i < bot.alive.size(); i++){
+        if(!bot.alive[i] || i == bot.self) continue;
+        if(pick-- == 0){
+            target = i;
+            break;
+        }
+    }
+
+    std::string out;
+    ActionRequestMessage request;
+    request.action = action;
+    request.target = (int32_t)target;
+    encodeActionRequest(out, request);
+    if(timed){
+        bot.started = nowMicros();
+        bot.awaiting = Awaiting::RESULT;
+    }
+    send(bot, std::move(out));
+}
+
+// Opens this tick's share of new connections, up to the concurrency target
+void LoadGenerator::rampUp(){
+    if(!running) return;
+
+    int budget = std::max(1, config.rate * RAMP_TICK_MS / 1000);
+    for(auto& bot : bots){
+        if(budget == 0) break;
+        if(bot->state != BotState::IDLE) continue;
+        connectBot(*bot);
+        budget--;
+    }
+}
+
+void LoadGenerator::progress(int elapsed){
+    std::cout << "[" << std::setw(3) << elapsed << "s] connected " << connected << ", connecting " << connecting
+              << ", turns/s " << turns - lastTurns << ", sessions " << sessions
+              << ", connect failures " << connectFailures << std::endl;
+    lastTurns = turns;
+}
+
+bool LoadGenerator::run(){
+    if(inet_pton(AF_INET, config.host.c_str(), &address.sin_addr) != 1){
+        std::cerr << "Invalid host address " << config.host << "\n";
+        return false;
+    }
+
+    int rampTimer = reactor.addTimer([this](){ rampUp(); });
+    reactor.armTimer(rampTimer, RAMP_TICK_MS, true);
+
+    int elapsed = 0;
+    int secondTimer = reactor.addTimer([&](){
+        progress(++elapsed);
+        if(elapsed >= config.duration){
+            running = false;
+            reactor.stop();
+        }
+    });
+    reactor.armTimer(secondTimer, 1000, true);
+
+    rampUp();
+    reactor.run();
+
+    reactor.removeTimer(rampTimer);
+    reactor.removeTimer(secondTimer);
+    for(auto& bot : bots) closeBot(*bot);
+    return true;
+}
+
+static void printLatency(const char *label, const Histogram& h){
+    std::cout << "  " << std::setw(18) << std::left << label << std::right
+              << " n=" << std::setw(9) << h.count()
+              << "  p50 " << std::setw(8) << h.percentile(0.50)
+              << "  p99 " << std::setw(8) << h.percentile(0.99)
+              << "  p999 " << std::setw(8) << h.percentile(0.999)
+              << "  max " << std::setw(8) << h.max() << "\n";
+}
+
+void LoadGenerator::report(double seconds){
+    std::cout << "\nLatency (microseconds):\n";
+    printLatency("connect", connectLatency);
+    printLatency("action -> prompt", actionRtt);
+    printLatency("target -> result", turnRtt);
+
+    std::cout << std::fixed << std::setprecision(0)
+              << "\nThroughput over " << std::setprecision(1) << seconds << "s: " << std::setprecision(0)
+              << turns / seconds << " turns/s, "
+              << frames / seconds << " frames/s, "
+              << bytes / seconds / 1024 << " KB/s received\n"
+              << "Sessions completed: " << sessions << ", dropped: " << disconnects
+              << ", connect failures: " << connectFailures << ", resyncs: " << resyncs << "\n";
+}
+
+static void usage(const char *prog){
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --host ADDR       server IPv4 address (default 127.0.0.1)\n"
+              << "  --port N          server port (default " << PORT << ")\n"
+              << "  --clients N       concurrent bot connections (default 1000)\n"
+              << "  --rate N          new connections per second (default 1000)\n"
+              << "  --duration N      seconds to run (default 30)\n"
+              << "  --combined        send action and target in one request instead of answering both prompts\n"
+              << "  --area N          percent of actions that are area attacks (default 0)\n"
+              << "  --ahead           also send the next combined order before its prompt, so the server plays queued orders\n";
+}
+
+int main(int argc, char *argv[]){
+    LoadConfig config;
+
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if(arg == "--host" && hasValue) config.host = argv[++i];
+        else if(arg == "--port" && hasValue) config.port = atoi(argv[++i]);
+        else if(arg == "--clients" && hasValue) config.clients = atoi(argv[++i]);
+        else if(arg == "--rate" && hasValue) config.rate = atoi(argv[++i]);
+        else if(arg == "--duration" && hasValue) config.duration = atoi(argv[++i]);
+        else if(arg == "--combined") config.combined = true;
+        else if(arg == "--area" && hasValue) config.area = atoi(argv[++i]);
+        else if(arg == "--ahead") config.ahead = true;
+        else{
+            usage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+    if(config.clients <= 0 || config.rate <= 0 || config.duration <= 0 || config.area < 0 || config.area > 100){
+        usage(argv[0]);
+        return 1;
+    }
+
+    LoadGenerator generator(config);
+    auto start = std::chrono::steady_clock::now();
+    if(!generator.run()) return 1;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    generator.report(seconds);
+    return 0;
+}
@@ -0,0 +1,998 @@
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <random>
+
+#include "match.h"
+#include "battleframes.h"
+#include "characters/factory.h"
+#include "constants.h"
+
+// Constructor: opens an empty lobby with a disarmed countdown timer
+Match::Match(Reactor& reactor, int id, const ServerConfig& config, WorkerMetrics& metrics, JournalSink *journals,
+             std::function<void()> onLobbyClosed, std::function<void()> onFinished)
+    : reactor(reactor), id(id), config(config), metrics(metrics), arena(metrics), countdownTimer(-1), countdownRemaining(0),
+      countdownRunning(false), phase(Phase::LOBBY),
+      readyPlayers(0), controller(nullptr), journals(journals), turnStage(TurnStage::ACTION), pendingAction(-1), turnStarted(0), turnTimeout(0), stateSeq(0),
+      ordersMissing(0), round(0), roundStarted(0),
+      onLobbyClosed(std::move(onLobbyClosed)), onFinished(std::move(onFinished)), alive(std::make_shared<bool>(true))
+{
+    countdownTimer = reactor.addTimer([this](){ onCountdownTick(); });
+}
+
+// Destructor: releases every fd still owned by the match
+Match::~Match(){
+    reactor.removeTimer(countdownTimer);
+    cancelTurnTimeout();
+    clients.forEach([this](ClientId, Client& client){
+        reactor.remove(client.sock);
+        close(client.sock);
+        metrics.connections.sub();
+    });
+
+    journal.reset(); // Hands the last chunk to the sink
+    delete controller;
+
+    // The arena goes back to the heap in one piece after the clients, the last members using it.
+    // Releasing it any earlier would pull memory from under frames still held up the stack, such
+    // as the round prompt when a round ends the battle from inside beginRound.
+}
+
+// Log prefix so interleaved output from many matches stays readable
+std::ostream& Match::log(){
+    return std::cout << "[match " << id << "] ";
+}
+
+// Number of sockets still open
+int Match::connectedCount(){
+    return (int)clients.size();
+}
+
+// Queues frames for one client and writes as much as the socket takes right away. Whatever is left
+// is flushed when epoll reports the socket writable, so a slow client never blocks the match.
+// Clients that already left are skipped.
+void Match::sendTo(ClientId id, Payload frames){
+    Client *client = clients.get(id);
+    if(!client || client->outbox.isAbandoned()) return;
+
+    int sock = client->sock;
+    SendQueue& queue = client->outbox;
+
+    bool wasEmpty = queue.empty();
+    queue.push(std::move(frames));
+
+    // A non-empty queue already has EPOLLOUT armed and keeps the order of earlier frames
+    if(!wasEmpty){
+        if(queue.size() > config.sendHighWater){
+            log() << "Client is not reading (" << queue.size() << " bytes queued), dropping it\n";
+            dropLater(id);
+        }
+        return;
+    }
+
+    FlushStatus status = queue.flush(sock, &metrics.sent);
+    if(status == FLUSH_ERROR){
+        perror("send failed; closing socket");
+        dropLater(id);
+    }
+    else if(status == FLUSH_PENDING){
+        reactor.modify(sock, EPOLLIN | EPOLLRDHUP | EPOLLOUT);
+    }
+}
+
+void Match::sendText(ClientId id, std::string_view text, uint8_t channel){
+    std::string& frame = newFrame();
+    encodeText(frame, channel, text);
+    sendTo(id, framePayload(frame));
+}
+
+void Match::sendPrompt(ClientId id, uint8_t kind, std::string_view text){
+    std::string& frame = newFrame();
+    encodePrompt(frame, kind, text);
+    sendTo(id, framePayload(frame));
+}
+
+// Broadcast frames encoded once to every open connection
+void Match::broadcastMessage(const Payload& frames) {
+    uint64_t start = monotonicNs();
+    clients.forEach([&](ClientId id, Client&){ sendTo(id, frames); });
+    metrics.broadcastFanout.record(monotonicNs() - start);
+}
+
+// Encodes text once and broadcasts it
+void Match::broadcastText(std::string_view text, uint8_t channel){
+    std::string& frame = newFrame();
+    encodeText(frame, channel, text);
+    broadcastMessage(framePayload(frame));
+}
+
+// Called on EPOLLOUT: keeps writing the queue and disarms EPOLLOUT once it is empty
+void Match::flushClient(ClientId id){
+    Client *client = clients.get(id);
+    if(!client || client->outbox.isAbandoned()) return;
+
+    FlushStatus status = client->outbox.flush(client->sock, &metrics.sent);
+    if(status == FLUSH_ERROR){
+        perror("send failed; closing socket");
+        dropLater(id);
+    }
+    else if(status == FLUSH_DONE){
+        reactor.modify(client->sock, EPOLLIN | EPOLLRDHUP);
+    }
+}
+
+// Stops talking to a client whose socket failed or who fell too far behind, and runs the regular
+// disconnect handling after the current event. Doing it right away could re-enter the game logic
+// in the middle of a broadcast. If the client is gone by then, its handle no longer resolves.
+void Match::dropLater(ClientId id){
+    Client *client = clients.get(id);
+    client->outbox.abandon();
+    reactor.remove(client->sock);
+
+    std::weak_ptr<bool> token = alive;
+    reactor.defer([this, token, id](){
+        if(token.expired()) return;
+        if(clients.contains(id) && phase != Phase::OVER) handleDisconnect(id);
+    });
+}
+
+// Writes what the socket still accepts from the queue, then closes it and removes the client
+void Match::closeClient(ClientId id){
+    Client *client = clients.get(id);
+    if(!client) return;
+
+    int sock = client->sock;
+    if(!client->outbox.isAbandoned()) client->outbox.flush(sock, &metrics.sent);
+    reactor.remove(sock);
+
+    // Closing with unread input (e.g. an order sent ahead) makes the kernel reset the connection,
+    // and the client would lose the frames just flushed
+    char discard[256];
+    while(recv(sock, discard, sizeof(discard), 0) > 0){}
+    close(sock);
+    metrics.connections.sub();
+
+    clients.remove(id);
+    if(phase == Phase::LOBBY) metrics.lobbyPlayers.set(clients.size());
+}
+
+// Graceful shutdown helper. Sends a shutdown message to all clients, closes their sockets, and ends the match
+void Match::shutdown(const std::string& message) {
+    std::string& frame = newFrame();
+    encodeShutdown(frame, message);
+    Payload payload = framePayload(frame);
+
+    // Sends custom message and closes every client socket
+    clients.forEach([&](ClientId id, Client& client){
+        client.outbox.push(payload);
+        closeClient(id);
+    });
+
+    log() << "SHUTDOWN: " << message;
+    finish();
+}
+
+// Marks the match as over and lets the owner destroy it once the current event is handled
+void Match::finish(){
+    if(phase == Phase::LOBBY){
+        metrics.lobbyPlayers.set(0);
+        if(onLobbyClosed) onLobbyClosed();
+    }
+    phase = Phase::OVER;
+    reactor.defer(onFinished);
+}
+
+// Parses a number typed by the player; anything else becomes -1 so it fails validation
+static int parseNumber(std::string_view text){
+    while(!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+
+    int value = -1;
+    auto res = std::from_chars(text.data(), text.data() + text.size(), value);
+    return res.ec == std::errc() ? value : -1;
+}
+
+// Extracts the number answering the given prompt from a MSG_INPUT or MSG_ACTION_REQUEST frame.
+// Returns false for frames that are not prompt answers.
+static bool promptAnswer(const Frame& frame, TurnStage stage, int& value){
+    if(frame.type == MSG_INPUT){
+        std::string_view text;
+        value = decodeInput(frame, text) ? parseNumber(text) : -1;
+        return true;
+    }
+    if(frame.type == MSG_ACTION_REQUEST){
+        ActionRequestMessage request;
+        if(!decodeActionRequest(frame, request)) value = -1;
+        else value = stage == TurnStage::ACTION ? request.action : request.target;
+        return true;
+    }
+    return false;
+}
+
+// Extracts a combined order: a MSG_ACTION_REQUEST carrying both an action and a target, or a
+// MSG_INPUT line with two numbers ("1 3"). An AREA_ATTACK request is complete without a target.
+// Returns false for anything else.
+static bool combinedAnswer(const Frame& frame, int& action, int& target){
+    if(frame.type == MSG_ACTION_REQUEST){
+        ActionRequestMessage request;
+        if(!decodeActionRequest(frame, request) || request.action < 0) return false;
+        if(request.target < 0 && request.action != AREA_ATTACK) return false;
+        action = request.action;
+        target = request.target;
+        return true;
+    }
+    if(frame.type != MSG_INPUT) return false;
+
+    std::string_view text;
+    if(!decodeInput(frame, text)) return false;
+    const char *end = text.data() + text.size();
+    auto first = std::from_chars(text.data(), end, action);
+    if(first.ec != std::errc() || first.ptr == end || *first.ptr != ' ') return false;
+
+    const char *next = first.ptr;
+    while(next < end && *next == ' ') next++;
+    auto second = std::from_chars(next, end, target);
+    if(second.ec != std::errc() || action < 0 || target < 0) return false;
+    for(const char *p = second.ptr; p < end; p++) if(*p != ' ' && *p != '\r' && *p != '\n') return false;
+    return true;
+}
+
+// Reads what the kernel has buffered for a client in one recv. Returns false if the peer is gone
+// or has flooded its receive buffer, in which case it is treated as disconnected.
+bool Match::readClient(ClientId id){
+    Client *client = clients.get(id);
+    FillStatus status = client->inbox.fill(client->sock, &metrics.received);
+
+    if(status == FILL_ERROR) perror("recv error");
+    else if(status == FILL_OVERFLOW) log() << "Client sent more than " << RECV_BUFFER_SIZE << " unread bytes, dropping it\n";
+
+    return status == FILL_OK;
+}
+
+// Next complete frame from a client. One that has left in the meantime has nothing more to read.
+DecodeStatus Match::nextFrame(ClientId id, Frame& frame){
+    Client *client = clients.get(id);
+    return client ? client->inbox.nextFrame(frame) : DECODE_INCOMPLETE;
+}
+
+// The match's frame buffer, emptied for the next frame to encode
+std::string& Match::newFrame(){
+    frameBuffer.clear();
+    return frameBuffer;
+}
+
+// Copies an encoded frame into the arena, or onto the heap if it is too large for the arena to
+// recycle (a large battle's snapshot)
+Payload Match::framePayload(std::string_view frame){
+    return MatchArena::fits(frame.size()) ? makePayload(frame, arena.resource()) : makePayload(frame);
+}
+
+// Adds a new client to the lobby and sends a welcome message
+void Match::addClient(int sock){
+    ClientId id = clients.insert(sock, arena.resource());
+    reactor.add(sock, EPOLLIN | EPOLLRDHUP, [this, id](uint32_t events){ onClientEvent(id, events); });
+    metrics.connections.add();
+    metrics.lobbyPlayers.set(clients.size());
+
+    std::string welcomeMsg = std::string(WELCOME_MSG) + " Currently " + std::to_string(clients.size()) + " player(s) here.\n";
+    sendText(id, welcomeMsg, CHANNEL_SYS);
+
+    log() << "Player connected! (" << clients.size() << "/" << config.maxPlayers << ")\n" << std::flush;
+
+    // A full lobby starts right away, otherwise the countdown restarts
+    if((int)clients.size() >= config.maxPlayers){
+        startSetup();
+        return;
+    }
+
+    bool wasRunning = countdownRunning;
+    resetCountdown();
+    if(wasRunning) sendText(id, countdownText(), CHANNEL_SYS);
+}
+
+std::string Match::countdownText(){
+    return "Game starts in " + std::to_string(countdownRemaining) + "s...\r";
+}
+
+// Restarts the lobby countdown, or stops it if there are not enough players. Only a countdown that
+// was stopped is announced to everyone; while it runs, the next tick shows the new time, so a
+// lobby filling up with thousands of players does not broadcast on every join.
+void Match::resetCountdown(){
+    if(connectedCount() < config.minPlayers){
+        reactor.armTimer(countdownTimer, 0, false);
+        countdownRunning = false;
+        return;
+    }
+
+    countdownRemaining = config.lobbyTime;
+    if(!countdownRunning) broadcastText(countdownText(), CHANNEL_SYS);
+
+    reactor.armTimer(countdownTimer, 1000, true);
+    countdownRunning = true;
+}
+
+// Called once per second by the countdown timer
+void Match::onCountdownTick(){
+    countdownRemaining--;
+    broadcastText(countdownText(), CHANNEL_SYS);
+
+    if(countdownRemaining <= 0) startSetup();
+}
+
+// Ends the lobby: sends the avatar prompt to everyone and waits for their answers
+void Match::startSetup(){
+    log() << "Starting game with " << clients.size() << " players!\n";
+    reactor.removeTimer(countdownTimer);
+    countdownTimer = -1;
+    countdownRunning = false;
+
+    // The lobby is closed, the owner routes new players elsewhere
+    phase = Phase::SETUP;
+    metrics.lobbyPlayers.set(0);
+    if(onLobbyClosed) onLobbyClosed();
+
+    broadcastText("Game starting with " + std::to_string(clients.size()) + " players. Get ready!\n\n", CHANNEL_SYS);
+    roster.reserve(clients.size()); // No one joins after this, so it never reallocates
+
+    // Send configuration prompt
+    std::string& askMsg = newFrame();
+    encodePrompt(askMsg, PROMPT_AVATAR, "Configure your avatar. Type your name and your class (ex.: Conan Halfling): ");
+    broadcastMessage(framePayload(askMsg));
+
+    // Players may have typed ahead while still in the lobby
+    for(ClientId id : clients.handles()){
+        if(phase != Phase::SETUP) break;
+        onClientEvent(id, 0);
+    }
+}
+
+// Waits for the MSG_INPUT frame answering the avatar prompt
+void Match::handleSetupInput(ClientId id){
+    Frame frame;
+    DecodeStatus status;
+
+    while((status = nextFrame(id, frame)) == DECODE_OK){
+        std::string_view text;
+        if(frame.type == MSG_INPUT && decodeInput(frame, text)){
+            configurePlayer(id, text);
+            checkSetupDone();
+            return;
+        }
+        // Anything else is ignored during setup
+    }
+
+    if(status == DECODE_MALFORMED) handleDisconnect(id);
+}
+
+// Creates the character described by the player's setup line
+void Match::configurePlayer(ClientId id, std::string_view input){
+    // Parse input
+    std::istringstream iss{std::string(input)};
+    std::string name, classType;
+    iss >> name >> classType;
+
+    ClassId classId;
+    if(!parseClassName(classType, classId)) classId = CLASS_HALFLING; // fallback
+
+    Character* player = &emplaceCharacter(roster, classId, name);
+    log() << "A " << player->getClass() << " named " << name << " was created! Life: "
+          << player->getHealth() << " Mana: " << player->getMana() << "\n";
+
+    player->setClientId(id);
+    clients.get(id)->player = player;
+    players.push_back(player);
+
+    // Confirmation message
+    std::string confirmMsg = "You selected " + name + ", race of " + player->getClass() + "!\n"
+                             "Please wait while others finish.\n";
+    sendText(id, confirmMsg, CHANNEL_SYS);
+
+    readyPlayers++;
+}
+
+// Returns the character owned by a client, or nullptr if it has not been configured yet
+Character* Match::playerAt(ClientId id){
+    Client *client = clients.get(id);
+    return client ? client->player : nullptr;
+}
+
+// Checks whether every connected player has configured an avatar and starts the battle
+void Match::checkSetupDone(){
+    if(phase != Phase::SETUP || readyPlayers < connectedCount()) return;
+
+    if((int)players.size() < config.minPlayers){
+        shutdown();
+        return;
+    }
+
+    broadcastText("All players are ready. Let's start!\n\n", CHANNEL_SYS);
+
+    // Creates controller with a fresh seed; logging it lets the battle be replayed
+    std::random_device device;
+    uint64_t seed = ((uint64_t)device() << 32) | device();
+    controller = new Controller(players, seed);
+    log() << "Battle seed: " << seed << "\n";
+
+    if(journals){
+        journal.reset(new JournalWriter(*journals, journals->pathFor("match-" + std::to_string(id) + ".nrj")));
+        journal->begin(seed, players);
+    }
+    phase = Phase::BATTLE;
+    metrics.battles.add();
+
+    // Everyone starts from a full snapshot; later turns only send what changed
+    for(Character *c : players) c->takeDirty();
+    broadcastSnapshot();
+    queued.assign(players.size(), ActionRequestMessage());
+    if(config.roundMode){
+        orders.assign(players.size(), Order());
+        beginRound();
+    }
+    else{
+        beginTurn();
+    }
+}
+
+void Match::sendActionPrompt(ClientId id){
+    sendPrompt(id, PROMPT_ACTION, "Your turn! Choose action (0=ATTACK, 1=CAST_SPELL, 2=SPECIAL_MOVE, 3=AREA_ATTACK), or action and target: ");
+}
+
+// Prompts the player to choose a target; clients list the candidates from their own roster
+void Match::sendTargetPrompt(ClientId id){
+    sendPrompt(id, PROMPT_TARGET, "Choose target:\n");
+}
+
+// Full state of every player at the current sequence number, for battle start and resyncs
+void Match::sendSnapshot(ClientId id){
+    Character *self = playerAt(id);
+    uint32_t selfNumber = self ? (uint32_t)playerNumber(self) : NO_PLAYER;
+
+    std::string& frame = newFrame();
+    encodeSnapshot(frame, stateSeq, selfNumber, players);
+    sendTo(id, framePayload(frame));
+}
+
+// Sends every client the same snapshot, encoded once. Only the few bytes naming the recipient's
+// player number differ, so each client gets its own copy of the prefix and shares the entries.
+void Match::broadcastSnapshot(){
+    std::string& frame = newFrame();
+    encodeSnapshot(frame, stateSeq, NO_PLAYER, players);
+    Payload entries = framePayload(std::string_view(frame).substr(SNAPSHOT_PREFIX_SIZE));
+    frame.resize(SNAPSHOT_PREFIX_SIZE);
+
+    clients.forEach([&](ClientId id, Client& client){
+        setSnapshotSelf(frame, client.player ? (uint32_t)playerNumber(client.player) : NO_PLAYER);
+        sendTo(id, framePayload(frame));
+        sendTo(id, entries);
+    });
+}
+
+// Broadcasts the fields that changed since the last update, if any, under the next sequence number
+void Match::broadcastChanges(){
+    takeChanges(players, changes);
+    if(changes.empty()) return;
+
+    std::string& frame = newFrame();
+    encodeDelta(frame, ++stateSeq, players, changes);
+    broadcastMessage(framePayload(frame));
+}
+
+// Prompts the next player for an action. The controller only hands out living players, so this
+// loops at most once per player that lost their socket without being marked dead.
+void Match::beginTurn(){
+    while(!controller->isBattleOver()){
+        Character *current = controller->getCurrentPlayer();
+        ClientId id = current->getClientId();
+
+        // A disconnected player leaves the turn order for good
+        if(!current->isAlive() || !clients.contains(id)){
+            current->setDead();
+            controller->nextTurn();
+            continue;
+        }
+
+        // An order sent ahead is played at once, without a prompt
+        turnStarted = monotonicNs();
+        int action, target;
+        if(takeQueuedOrder(current, action, target)){
+            pendingAction = action;
+            playTurn(current, target >= 0 ? players[target] : nullptr);
+            continue;
+        }
+
+        // Prompts the player for their action
+        turnStage = TurnStage::ACTION;
+        pendingAction = -1;
+        cancelTurnTimeout();
+        if(config.turnTimeout > 0) turnTimeout = reactor.scheduleTimeout(config.turnTimeout * 1000, [this](){ onTurnTimeout(); });
+        sendActionPrompt(id);
+
+        // The player may already have typed the answer
+        onClientEvent(id, 0);
+        return;
+    }
+
+    endBattle();
+}
+
+void Match::cancelTurnTimeout(){
+    reactor.cancelTimeout(turnTimeout);
+    turnTimeout = 0;
+}
+
+// The current player let the turn deadline pass: the turn is played or skipped for them, so an
+// idle player cannot stall the match
+void Match::onTurnTimeout(){
+    turnTimeout = 0;
+    if(phase != Phase::BATTLE) return;
+
+    Character *current = controller->getCurrentPlayer();
+    log() << current->getName() << " timed out\n";
+
+    if(config.turnTimeoutAutoplay){
+        Character *target = weakestEnemy(current);
+        if(target){
+            broadcastText(current->getName() + " ran out of time and attacks " + target->getName() + " automatically!\n");
+            pendingAction = ATTACK;
+            resolveTurn(current, target);
+            return;
+        }
+    }
+
+    broadcastText(current->getName() + " ran out of time and skips the turn!\n");
+    controller->nextTurn();
+    beginTurn();
+}
+
+// Living enemy with the least health, the automatic target on timeouts. The choice uses no
+// randomness, so the battle's generator (and its journal replay) is unaffected.
+Character* Match::weakestEnemy(Character *attacker){
+    Character *target = nullptr;
+    for(Character *c : players){
+        if(c == attacker || !c->isAlive()) continue;
+        if(!target || c->getHealth() < target->getHealth()) target = c;
+    }
+    return target;
+}
+
+// True if value names a living player other than the attacker
+bool Match::validTarget(Character *attacker, int value){
+    return value >= 0 && value < (int)players.size() && players[value] != attacker && players[value]->isAlive();
+}
+
+// Keeps a combined order sent before the player's turn (or round) for when it comes, so it can be
+// played without a prompt. A later order replaces it.
+void Match::queueOrder(ClientId id, int action, int target){
+    Character *player = playerAt(id);
+    if(!player || !player->isAlive()){
+        sendText(id, "Wait for your turn.\n");
+        return;
+    }
+    if(action >= ACTION_COUNT || (action != AREA_ATTACK && (target >= (int)players.size() || players[target] == player))){
+        sendText(id, "Invalid order! \n");
+        return;
+    }
+
+    ActionRequestMessage& order = queued[playerNumber(player)];
+    order.action = action;
+    order.target = action == AREA_ATTACK ? -1 : target;
+    sendText(id, config.roundMode ? "Order queued for the next round.\n" : "Order queued for your turn.\n");
+}
+
+// Takes the player's queued order, if any; target is -1 for an area action. One whose target has
+// died meanwhile is dropped and the player is prompted as usual.
+bool Match::takeQueuedOrder(Character *player, int& action, int& target){
+    ActionRequestMessage& order = queued[playerNumber(player)];
+    if(order.action < 0) return false;
+
+    action = order.action;
+    target = order.target;
+    order = ActionRequestMessage();
+    if(action == AREA_ATTACK || validTarget(player, target)) return true;
+
+    sendText(player->getClientId(), "The target of your queued order is already down.\n");
+    return false;
+}
+
+// Consumes the current player's answers to the action and target prompts. Other players can only
+// ask for a resync while they wait.
+void Match::handleTurnInput(ClientId id){
+    if(config.roundMode){
+        handleRoundInput(id);
+        return;
+    }
+
+    Character *current = controller->getCurrentPlayer();
+    Frame frame;
+    DecodeStatus status = DECODE_INCOMPLETE;
+
+    if(current->getClientId() != id){
+        int action, target;
+        while((status = nextFrame(id, frame)) == DECODE_OK){
+            if(frame.type == MSG_RESYNC) sendSnapshot(id);
+            else if(combinedAnswer(frame, action, target)) queueOrder(id, action, target);
+            else if(frame.type == MSG_INPUT || frame.type == MSG_ACTION_REQUEST) sendText(id, "Wait for your turn.\n");
+        }
+        if(status == DECODE_MALFORMED) handleDisconnect(id);
+        return;
+    }
+
+    while(phase == Phase::BATTLE && controller->getCurrentPlayer() == current &&
+          (status = nextFrame(id, frame)) == DECODE_OK){
+        if(frame.type == MSG_RESYNC){
+            sendSnapshot(id);
+            continue;
+        }
+
+        // Action and target at once, taken or rejected as a whole
+        int action, target;
+        if(combinedAnswer(frame, action, target)){
+            if(action == AREA_ATTACK || (action < ACTION_COUNT && validTarget(current, target))){
+                pendingAction = action;
+                resolveTurn(current, action == AREA_ATTACK ? nullptr : players[target]);
+                return;
+            }
+
+            sendText(id, "Invalid order! Try again.\n");
+            turnStage = TurnStage::ACTION;
+            sendActionPrompt(id);
+            continue;
+        }
+
+        int value;
+        if(!promptAnswer(frame, turnStage, value)) continue;
+
+        if(turnStage == TurnStage::ACTION){
+            if(value < 0 || value >= ACTION_COUNT){
+                sendText(id, "Invalid action! Try again.\n");
+                sendActionPrompt(id);
+                continue;
+            }
+
+            // Area actions have no target to ask for
+            pendingAction = value;
+            if(value == AREA_ATTACK){
+                resolveTurn(current, nullptr);
+                return;
+            }
+            turnStage = TurnStage::TARGET;
+            sendTargetPrompt(id);
+        }
+        else{
+            if(validTarget(current, value)){
+                resolveTurn(current, players[value]);
+                return;
+            }
+
+            sendText(id, "Invalid target! \n");
+            sendTargetPrompt(id);
+        }
+    }
+
+    if(status == DECODE_MALFORMED) handleDisconnect(id);
+}
+
+// Executes the chosen action on the target, broadcasts the result to all players and starts the next turn
+void Match::resolveTurn(Character *current, Character *target){
+    playTurn(current, target);
+    beginTurn();
+}
+
+// Plays pendingAction for the current player and moves the turn on
+void Match::playTurn(Character *current, Character *target){
+    cancelTurnTimeout();
+    uint64_t start = monotonicNs();
+    metrics.thinkTime.record(start - turnStarted);
+
+    playAction(current, pendingAction, target);
+    broadcastChanges();
+    metrics.turnResolution.record(monotonicNs() - start);
+
+    controller->nextTurn();
+}
+
+// Applies one action, journals it and tells everyone the result. The state it changed goes out
+// with the next broadcastChanges, which for an area action is one delta however many it hit.
+void Match::playAction(Character *attacker, int action, Character *target){
+    ActionResult result = controller->applyAction(attacker, action, target);
+
+    int attackerNumber = playerNumber(attacker);
+    int targetNumber = target ? playerNumber(target) : -1;
+    if(journal) journal->recordTurn((uint32_t)attackerNumber, action, target ? (uint32_t)targetNumber : JOURNAL_NO_TARGET, result);
+
+    std::string& frame = newFrame();
+    encodeTurnResult(frame, turnText, players, attackerNumber, action, targetNumber, result);
+    broadcastMessage(framePayload(frame));
+    metrics.turns.add();
+}
+
+// Round mode: prompts every living player at once, under one deadline for the whole round
+void Match::beginRound(){
+    if(controller->isBattleOver()){
+        endBattle();
+        return;
+    }
+
+    round++;
+    roundStarted = monotonicNs();
+    ordersMissing = 0;
+    for(Order& order : orders) order = Order();
+
+    turnText.assign("Round ");
+    turnText += std::to_string(round);
+    turnText += "! Choose action (0=ATTACK, 1=CAST_SPELL, 2=SPECIAL_MOVE, 3=AREA_ATTACK), or action and target: ";
+    std::string& frame = newFrame();
+    encodePrompt(frame, PROMPT_ACTION, turnText);
+    Payload prompt = framePayload(frame);
+    for(size_t i = 0; i < players.size(); ++i){
+        Character *c = players[i];
+        if(!c->isAlive()) continue;
+
+        // Orders sent ahead count as this round's choice
+        Order& order = orders[i];
+        if(takeQueuedOrder(c, order.action, order.target)){
+            order.ready = true;
+            continue;
+        }
+
+        ordersMissing++;
+        sendTo(c->getClientId(), prompt);
+    }
+
+    cancelTurnTimeout();
+    if(ordersMissing == 0){
+        resolveRound();
+        return;
+    }
+    if(config.turnTimeout > 0) turnTimeout = reactor.scheduleTimeout(config.turnTimeout * 1000, [this](){ onRoundTimeout(); });
+
+    // Players may already have typed their answers; stops if those complete the round
+    uint32_t started = round;
+    for(Character *c : players){
+        if(phase != Phase::BATTLE || round != started) break;
+        if(c->isAlive()) handleRoundInput(c->getClientId());
+    }
+}
+
+// The round deadline passed: everyone still choosing attacks the weakest enemy or skips, as in
+// turn mode, and the round is played without waiting any longer
+void Match::onRoundTimeout(){
+    turnTimeout = 0;
+    if(phase != Phase::BATTLE) return;
+
+    log() << ordersMissing << " player(s) timed out in round " << round << "\n";
+    for(size_t i = 0; i < players.size(); ++i){
+        Character *c = players[i];
+        Order& order = orders[i];
+        if(!c->isAlive() || order.ready) continue;
+
+        order.ready = true;
+        order.action = -1;
+        Character *target = config.turnTimeoutAutoplay ? weakestEnemy(c) : nullptr;
+        if(target){
+            order.action = ATTACK;
+            order.target = playerNumber(target);
+            broadcastText(c->getName() + " ran out of time and attacks " + target->getName() + " automatically!\n");
+        }
+        else{
+            broadcastText(c->getName() + " ran out of time and skips the round!\n");
+        }
+    }
+
+    ordersMissing = 0;
+    resolveRound();
+}
+
+// Round mode: consumes a player's action and target answers until their order is in. Once it is,
+// further answers wait for the next round's prompt.
+void Match::handleRoundInput(ClientId id){
+    Character *player = playerAt(id);
+    Frame frame;
+    DecodeStatus status = DECODE_INCOMPLETE;
+    uint32_t current = round;
+
+    while(phase == Phase::BATTLE && round == current &&
+          (status = nextFrame(id, frame)) == DECODE_OK){
+        if(frame.type == MSG_RESYNC){
+            sendSnapshot(id);
+            continue;
+        }
+
+        Order *order = player && player->isAlive() ? &orders[playerNumber(player)] : nullptr;
+        int action, target;
+        bool combined = combinedAnswer(frame, action, target);
+        if(!order || order->ready){
+            if(combined) queueOrder(id, action, target);
+            else if(frame.type == MSG_INPUT || frame.type == MSG_ACTION_REQUEST) sendText(id, "Wait for the next round.\n");
+            continue;
+        }
+
+        if(combined){
+            // Action and target at once, taken or rejected as a whole
+            if(action >= ACTION_COUNT || (action != AREA_ATTACK && !validTarget(player, target))){
+                sendText(id, "Invalid order! Try again.\n");
+                order->stage = TurnStage::ACTION;
+                sendActionPrompt(id);
+                continue;
+            }
+            order->action = action;
+            order->target = action == AREA_ATTACK ? -1 : target;
+        }
+        else{
+            int value;
+            if(!promptAnswer(frame, order->stage, value)) continue;
+
+            if(order->stage == TurnStage::ACTION){
+                if(value < 0 || value >= ACTION_COUNT){
+                    sendText(id, "Invalid action! Try again.\n");
+                    sendActionPrompt(id);
+                    continue;
+                }
+
+                order->action = value;
+                order->target = -1;
+                if(value != AREA_ATTACK){
+                    order->stage = TurnStage::TARGET;
+                    sendTargetPrompt(id);
+                    continue;
+                }
+            }
+            else{
+                if(!validTarget(player, value)){
+                    sendText(id, "Invalid target! \n");
+                    sendTargetPrompt(id);
+                    continue;
+                }
+                order->target = value;
+            }
+        }
+
+        order->ready = true;
+        metrics.thinkTime.record(monotonicNs() - roundStarted);
+        sendText(id, "Waiting for the other players...\n");
+        if(--ordersMissing == 0) resolveRound();
+    }
+
+    if(status == DECODE_MALFORMED) handleDisconnect(id);
+}
+
+// Plays the round's orders in one batch, in turn order from the controller's current player, and
+// sends the state they changed as a single delta. A player killed earlier in the batch does not
+// act, and an attack on a player who is already dead is lost. The next round starts one player
+// further along, so nobody always moves first.
+void Match::resolveRound(){
+    cancelTurnTimeout();
+    uint64_t start = monotonicNs();
+
+    while(!controller->isBattleOver()){
+        Character *current = controller->getCurrentPlayer();
+        Order& order = orders[playerNumber(current)];
+        if(order.resolved) break;
+        order.resolved = true;
+
+        if(order.action >= 0){
+            Character *target = order.target >= 0 ? players[order.target] : nullptr;
+            if(!target || target->isAlive()){
+                playAction(current, order.action, target);
+            }
+            else{
+                turnText.assign(current->getName());
+                turnText += "'s target ";
+                turnText += target->getName();
+                turnText += " is already down.\n";
+                broadcastText(turnText);
+            }
+        }
+        controller->nextTurn();
+    }
+    controller->nextTurn();
+
+    broadcastChanges();
+    metrics.turnResolution.record(monotonicNs() - start);
+    beginRound();
+}
+
+// Position of c in the turn order, which is also its number in the protocol and the journal. The
+// controller numbers players in that order when the battle starts.
+int Match::playerNumber(Character *c){
+    return c->getRosterIndex();
+}
+
+// Sends the "Battle is over!" message and closes every socket
+void Match::endBattle(){
+    cancelTurnTimeout();
+    if(journal){
+        int winner = -1;
+        for(size_t i = 0; i < players.size(); ++i) if(players[i]->isAlive()) winner = (int)i;
+        journal->end(winner);
+    }
+
+    // End of the game
+    std::string& frame = newFrame();
+    encodeShutdown(frame, "Battle is over!\n");
+    broadcastMessage(framePayload(frame));
+    for(ClientId id : clients.handles()) closeClient(id);
+
+    log() << "Battle is over!\n";
+    finish();
+}
+
+// Handles a client hanging up in any phase
+void Match::handleDisconnect(ClientId id){
+    if(phase == Phase::LOBBY){
+        closeClient(id);
+
+        std::string disconMsg = std::string(DISCONNECT_MSG) + " Now " + std::to_string(clients.size()) + "/" +
+            std::to_string(config.maxPlayers) + " players in lobby.\n";
+        broadcastText(disconMsg, CHANNEL_SYS);
+        log() << disconMsg << std::flush;
+
+        resetCountdown();
+        return;
+    }
+
+    Character *player = playerAt(id);
+    closeClient(id);
+
+    // Handles player disconnection during setup and ends the match if too few players remain
+    if(phase == Phase::SETUP){
+        log() << "Player disconnected during avatar setup!\n";
+        if(player){
+            // Leaves the roster before the battle is built, so neither the Controller nor the
+            // journal ever sees them
+            players.erase(std::find(players.begin(), players.end(), player));
+            readyPlayers--;
+        }
+
+        if(connectedCount() < config.minPlayers){
+            shutdown("Insufficient players in lobby!");
+            return;
+        }
+        checkSetupDone();
+        return;
+    }
+
+    if(phase == Phase::BATTLE && player){
+        bool wasCurrent = !config.roundMode && controller->getCurrentPlayer() == player;
+        bool wasChoosing = config.roundMode && player->isAlive() && !orders[playerNumber(player)].ready;
+        player->setDead();
+        if(journal) journal->recordDisconnect((uint32_t)playerNumber(player));
+        broadcastText(player->getName() + " disconnected and is out!\n");
+        broadcastChanges();
+
+        if(wasCurrent){
+            controller->nextTurn();
+            beginTurn();
+        }
+        else if(controller->isBattleOver()){
+            endBattle();
+        }
+        else if(wasChoosing && --ordersMissing == 0){
+            resolveRound();
+        }
+    }
+}
+
+// Reads from a client and advances whatever phase the match is in
+void Match::onClientEvent(ClientId id, uint32_t events){
+    if(!clients.contains(id) || phase == Phase::OVER) return;
+
+    if(events & EPOLLOUT) flushClient(id);
+
+    bool readable = events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR);
+    if(readable && !readClient(id)){
+        handleDisconnect(id);
+        return;
+    }
+
+    if(phase == Phase::SETUP){
+        if(playerAt(id) == nullptr) handleSetupInput(id);
+    }
+    else if(phase == Phase::BATTLE){
+        handleTurnInput(id);
+    }
+}
@@ -0,0 +1,181 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "arena.h"
+#include "battleframes.h"
+#include "constants.h"
+#include "controller.h"
+#include "journal.h"
+#include "metrics.h"
+#include "protocol.h"
+#include "reactor.h"
+#include "recvbuffer.h"
+#include "sendqueue.h"
+#include "serverconfig.h"
+#include "slotmap.h"
+#include "characters/character.h"
+#include "characters/classes.h"
+
+// Phases of a match, all driven by the owning worker's reactor
+enum class Phase {
+    LOBBY,
+    SETUP,
+    BATTLE,
+    OVER
+};
+
+// What the current player is expected to type next
+enum class TurnStage {
+    ACTION,
+    TARGET
+};
+
+// One lobby + battle. Owns its players, client sockets and Controller; every method runs on
+// the thread of the reactor it was created with, so no locking is needed.
+class Match {
+    private:
+        Reactor& reactor;
+        int id;
+        const ServerConfig& config;
+        WorkerMetrics& metrics; // Owned by the worker, written only from its thread
+
+        std::vector<AnyCharacter> roster;  // Every character by value, reserved at setup so pointers stay valid
+        std::vector<Character *> players;  // Into roster, in turn order; a player's number is its position
+        MatchArena arena;                  // Frames and send queues; declared before clients, which use it
+
+        // An open connection. It leaves the registry when its socket closes, at any phase, and
+        // every handle to it (in characters, event handlers, deferred drops) stops resolving.
+        struct Client {
+            int sock;
+            RecvBuffer inbox;            // Bytes received, not yet decoded into frames
+            SendQueue outbox;            // Frames waiting for the socket to accept them
+            Character *player = nullptr; // Set once the avatar is configured
+
+            Client(int sock, std::pmr::memory_resource *memory) : sock(sock), inbox(RECV_BUFFER_SIZE), outbox(memory) {}
+        };
+        using ClientId = SlotHandle;
+        SlotMap<Client> clients;
+
+        int countdownTimer;
+        int countdownRemaining;
+        bool countdownRunning;
+
+        Phase phase;
+        int readyPlayers;
+
+        Controller *controller;
+        JournalSink *journals;                  // nullptr when journaling is disabled
+        std::unique_ptr<JournalWriter> journal; // Opened when the battle starts
+        TurnStage turnStage;
+        int pendingAction;
+        uint64_t turnStarted; // When the current player was prompted, for the think time metric
+        TimeoutId turnTimeout; // Deadline of the current turn, 0 when none is pending
+        uint32_t stateSeq;     // Sequence number of the last state update sent to clients
+        std::vector<PlayerChange> changes; // Reused by broadcastChanges
+        std::string turnText;              // Reused to narrate turn results and build prompts
+        std::string frameBuffer;           // Reused to encode frames before they are copied to the arena
+
+        // Round mode: what each player, by number, chose this round
+        struct Order {
+            TurnStage stage = TurnStage::ACTION;
+            int action = -1;       // -1 = the player skips the round
+            int target = -1;       // -1 for an area action
+            bool ready = false;    // Chosen, or decided for them at the deadline
+            bool resolved = false; // Played in this round's batch
+        };
+        std::vector<Order> orders;
+        int ordersMissing;     // Living players still choosing
+        uint32_t round;
+        uint64_t roundStarted; // When the round's prompts went out, for the think time metric
+
+        // Combined orders sent ahead of a player's turn or round, by player number; action -1 when none
+        std::vector<ActionRequestMessage> queued;
+
+        std::function<void()> onLobbyClosed; // Lobby left the LOBBY phase, no more clients accepted
+        std::function<void()> onFinished;    // Match is over and can be destroyed
+
+        std::shared_ptr<bool> alive; // Deferred work holds a weak_ptr to skip matches destroyed meanwhile
+
+        std::ostream& log();
+
+        // Connections
+        int connectedCount();
+        void sendTo(ClientId id, Payload frames);
+        void sendText(ClientId id, std::string_view text, uint8_t channel = CHANNEL_GAME);
+        void sendPrompt(ClientId id, uint8_t kind, std::string_view text);
+        void broadcastMessage(const Payload& frames);
+        void broadcastText(std::string_view text, uint8_t channel = CHANNEL_GAME);
+        void flushClient(ClientId id);
+        void dropLater(ClientId id);
+        void closeClient(ClientId id);
+        bool readClient(ClientId id);
+        DecodeStatus nextFrame(ClientId id, Frame& frame);
+        std::string& newFrame();
+        Payload framePayload(std::string_view frame);
+
+        // Lobby
+        void resetCountdown();
+        std::string countdownText();
+        void onCountdownTick();
+
+        // Setup
+        void startSetup();
+        void handleSetupInput(ClientId id);
+        void configurePlayer(ClientId id, std::string_view input);
+        Character* playerAt(ClientId id);
+        void checkSetupDone();
+
+        // Battle
+        void sendActionPrompt(ClientId id);
+        void sendTargetPrompt(ClientId id);
+        void sendSnapshot(ClientId id);
+        void broadcastSnapshot();
+        void broadcastChanges();
+        void beginTurn();
+        void cancelTurnTimeout();
+        void onTurnTimeout();
+        void handleTurnInput(ClientId id);
+        void resolveTurn(Character *current, Character *target);
+        void playTurn(Character *current, Character *target);
+        void queueOrder(ClientId id, int action, int target);
+        bool takeQueuedOrder(Character *player, int& action, int& target);
+        void playAction(Character *attacker, int action, Character *target);
+        bool validTarget(Character *attacker, int value);
+        Character* weakestEnemy(Character *attacker);
+        void beginRound();
+        void onRoundTimeout();
+        void handleRoundInput(ClientId id);
+        void resolveRound();
+        int playerNumber(Character *c);
+        void endBattle();
+
+        void handleDisconnect(ClientId id);
+        void onClientEvent(ClientId id, uint32_t events);
+        void finish();
+
+    public:
+        Match(Reactor& reactor, int id, const ServerConfig& config, WorkerMetrics& metrics, JournalSink *journals,
+              std::function<void()> onLobbyClosed, std::function<void()> onFinished);
+        ~Match();
+
+        Match(const Match&) = delete;
+        Match& operator=(const Match&) = delete;
+
+        int getId() const { return id; }
+        Phase getPhase() const { return phase; }
+
+        // Hands an accepted, non-blocking socket to the lobby
+        void addClient(int sock);
+
+        // Graceful shutdown. Sends a message to all clients and closes their sockets
+        void shutdown(const std::string& message = "Server is shutting down.\n");
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <sstream>
+
+#include "metrics.h"
+
+StatsServer::StatsServer(std::vector<const WorkerMetrics *> workers) : workers(std::move(workers)), listenFd(-1) {}
+
+// The thread blocks in accept() for the life of the process, so it is detached rather than joined
+StatsServer::~StatsServer(){
+    if(thread.joinable()) thread.detach();
+}
+
+bool StatsServer::start(int port){
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(listenFd < 0){
+        perror("stats socket failed");
+        return false;
+    }
+
+    int opt = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    // Loopback only: the metrics are for the operator, not for players
+    struct sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+
+    if(bind(listenFd, (struct sockaddr *)&address, sizeof(address)) < 0 || ::listen(listenFd, 16) < 0){
+        perror("stats bind failed");
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    thread = std::thread([this](){ run(); });
+    return true;
+}
+
+// Answers every request, whatever its path, with the current metrics
+void StatsServer::run(){
+    while(true){
+        int client = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if(client < 0){
+            if(errno != EINTR) perror("stats accept failed");
+            continue;
+        }
+
+        // The request itself is not needed, only drained so the client sees a clean close
+        char request[1024];
+        struct timeval timeout = {1, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        recv(client, request, sizeof(request), 0);
+
+        std::string body = render();
+        std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                               std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+
+        const char *data = response.data();
+        size_t left = response.size();
+        while(left > 0){
+            ssize_t n = send(client, data, left, MSG_NOSIGNAL);
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) break;
+            data += n;
+            left -= (size_t)n;
+        }
+        close(client);
+    }
+}
+
+// One line per worker for a counter or gauge
+static void renderCounter(std::ostringstream& out, const std::vector<const WorkerMetrics *>& workers,
+                          const char *name, const char *type, const char *help,
+                          const Counter WorkerMetrics::*field){
+    out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    for(size_t i = 0; i < workers.size(); i++) out << name << "{worker=\"" << i << "\"} " << (workers[i]->*field).get() << "\n";
+}
+
+static void renderIo(std::ostringstream& out, const std::vector<const WorkerMetrics *>& workers,
+                     const char *name, const char *help, const IoCounters WorkerMetrics::*field, bool bytes){
+    out << "# HELP " << name << " " << help << "\n# TYPE " << name << " counter\n";
+    for(size_t i = 0; i < workers.size(); i++){
+        const IoCounters& io = workers[i]->*field;
+        out << name << "{worker=\"" << i << "\"} " << (bytes ? io.bytes.get() : io.calls.get()) << "\n";
+    }
+}
+
+// Histogram merged over all workers, as a summary with quantiles
+static void renderHistogram(std::ostringstream& out, const std::vector<const WorkerMetrics *>& workers,
+                            const char *name, const char *help, const SharedHistogram WorkerMetrics::*field){
+    Histogram merged;
+    for(const WorkerMetrics *w : workers) (w->*field).snapshot(merged);
+
+    out << "# HELP " << name << " " << help << "\n# TYPE " << name << " summary\n";
+    for(double q : {0.5, 0.9, 0.99, 0.999}) out << name << "{quantile=\"" << q << "\"} " << merged.percentile(q) << "\n";
+    out << name << "{quantile=\"1\"} " << merged.max() << "\n";
+    out << name << "_sum " << (uint64_t)(merged.mean() * merged.count()) << "\n";
+    out << name << "_count " << merged.count() << "\n";
+}
+
+std::string StatsServer::render() const {
+    std::ostringstream out;
+
+    renderIo(out, workers, "rpg_sent_bytes_total", "Bytes written to client sockets.", &WorkerMetrics::sent, true);
+    renderIo(out, workers, "rpg_send_calls_total", "sendmsg system calls.", &WorkerMetrics::sent, false);
+    renderIo(out, workers, "rpg_received_bytes_total", "Bytes read from client sockets.", &WorkerMetrics::received, true);
+    renderIo(out, workers, "rpg_recv_calls_total", "recv system calls.", &WorkerMetrics::received, false);
+
+    renderCounter(out, workers, "rpg_connections", "gauge", "Open client connections.", &WorkerMetrics::connections);
+    renderCounter(out, workers, "rpg_accepted_total", "counter", "Client connections accepted.", &WorkerMetrics::accepted);
+    renderCounter(out, workers, "rpg_active_matches", "gauge", "Matches in progress, open lobby included.", &WorkerMetrics::activeMatches);
+    renderCounter(out, workers, "rpg_lobby_players", "gauge", "Players waiting in the open lobby.", &WorkerMetrics::lobbyPlayers);
+    renderCounter(out, workers, "rpg_battles_total", "counter", "Battles started.", &WorkerMetrics::battles);
+    renderCounter(out, workers, "rpg_turns_total", "counter", "Actions resolved.", &WorkerMetrics::turns);
+    renderCounter(out, workers, "rpg_heap_allocations_total", "counter", "Global operator new calls on the worker thread.", &WorkerMetrics::heapCalls);
+    renderCounter(out, workers, "rpg_arena_bytes", "gauge", "Heap bytes held by match arenas.", &WorkerMetrics::arenaBytes);
+    renderCounter(out, workers, "rpg_arena_chunks_total", "counter", "Heap chunks taken by match arenas.", &WorkerMetrics::arenaChunks);
+
+    renderHistogram(out, workers, "rpg_think_time_ns", "Time from the action prompt to the chosen target.", &WorkerMetrics::thinkTime);
+    renderHistogram(out, workers, "rpg_turn_resolution_ns", "Time to apply an action and broadcast its result.", &WorkerMetrics::turnResolution);
+    renderHistogram(out, workers, "rpg_broadcast_fanout_ns", "Time to queue and write one frame to every player.", &WorkerMetrics::broadcastFanout);
+
+    return out.str();
+}
@@ -0,0 +1,119 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "histogram.h"
+
+// Server instrumentation. Every worker thread owns one WorkerMetrics block and is its only writer;
+// the stats thread only reads. Single-writer updates are a relaxed load and store, with no locked
+// instruction and no shared cache line between workers, so scraping costs the turn loop nothing.
+
+// Counter or gauge with a single writer thread
+class Counter {
+    private:
+        std::atomic<uint64_t> value{0};
+
+    public:
+        void add(uint64_t n = 1) { value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+        void sub(uint64_t n = 1) { value.store(value.load(std::memory_order_relaxed) - n, std::memory_order_relaxed); }
+        void set(uint64_t n) { value.store(n, std::memory_order_relaxed); }
+        uint64_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+// Histogram with a single writer thread that other threads can copy at any time
+class SharedHistogram {
+    private:
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+
+    public:
+        SharedHistogram() : buckets(new std::atomic<uint64_t>[Histogram::BUCKETS]) {
+            for(size_t i = 0; i < Histogram::BUCKETS; i++) buckets[i].store(0, std::memory_order_relaxed);
+        }
+
+        void record(uint64_t value){
+            std::atomic<uint64_t>& bucket = buckets[Histogram::bucketOf(value)];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        // Adds the current counts to into
+        void snapshot(Histogram& into) const {
+            for(size_t i = 0; i < Histogram::BUCKETS; i++){
+                uint64_t n = buckets[i].load(std::memory_order_relaxed);
+                if(n > 0) into.addToBucket(i, n);
+            }
+        }
+};
+
+// Syscalls and bytes of one direction of socket I/O
+struct IoCounters {
+    Counter calls;
+    Counter bytes;
+};
+
+// Aligned so two workers never write the same cache line
+struct alignas(64) WorkerMetrics {
+    // Sockets
+    IoCounters sent;     // sendmsg calls and bytes written
+    IoCounters received; // recv calls and bytes read
+    Counter connections; // Open client sockets
+    Counter accepted;    // Client sockets accepted so far
+
+    // Matches
+    Counter activeMatches; // Lobby included
+    Counter lobbyPlayers;  // Players waiting in the open lobby
+    Counter battles;       // Battles started so far
+    Counter turns;         // Actions resolved so far
+
+    // Memory
+    Counter heapCalls;   // Global operator new calls made on the worker's thread
+    Counter arenaBytes;  // Bytes the worker's match arenas hold from the heap
+    Counter arenaChunks; // Chunks those arenas took from the heap so far
+
+    // Latencies, in nanoseconds
+    SharedHistogram thinkTime;       // Action prompt sent -> target chosen
+    SharedHistogram turnResolution;  // Applying an action and broadcasting its result
+    SharedHistogram broadcastFanout; // Queueing and writing one frame to every player
+};
+
+// Counts every global operator new call the calling thread makes from now on into counter, or
+// stops counting for nullptr. Defined in heapcount.cpp, which replaces the global allocation
+// functions in the binaries it is linked into.
+void countHeapCalls(Counter *counter);
+
+inline uint64_t monotonicNs(){
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Serves every worker's metrics as plain text (Prometheus exposition format) over HTTP on a
+// loopback port, from its own thread
+class StatsServer {
+    private:
+        std::vector<const WorkerMetrics *> workers;
+        int listenFd;
+        std::thread thread;
+
+        void run();
+
+    public:
+        explicit StatsServer(std::vector<const WorkerMetrics *> workers);
+        ~StatsServer();
+
+        StatsServer(const StatsServer&) = delete;
+        StatsServer& operator=(const StatsServer&) = delete;
+
+        // Binds 127.0.0.1:port and starts answering requests
+        bool start(int port);
+
+        // Current values, as served to scrapers
+        std::string render() const;
+};
+
+#endif
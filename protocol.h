@@ -0,0 +1,394 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+// Binary wire protocol shared by the server, the client and any bot.
+//
+// Every message is a frame: a 6 byte header followed by a typed payload.
+//
+//   u32 payload length | u8 protocol version | u8 message type | payload...
+//
+// Integers are big-endian, strings are a u16 length followed by the raw bytes. Decoding
+// never copies: strings come back as string_views into the receive buffer, so they are only
+// valid until the buffer is consumed.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#define PROTOCOL_VERSION 2
+#define FRAME_HEADER_SIZE 6
+#define MAX_FRAME_PAYLOAD (1 << 20) // Larger frames are treated as malformed
+
+enum MessageType : uint8_t {
+    // Server -> client
+    MSG_TEXT = 1,          // Informational text (lobby, countdown, notices)
+    MSG_PROMPT = 2,        // The server is waiting for this client's input
+    MSG_ACTION_RESULT = 3, // Outcome of a resolved action
+    MSG_SNAPSHOT = 4,      // Full roster, sent when the battle starts and on resync
+    MSG_SHUTDOWN = 5,      // The server is closing the connection
+    MSG_DELTA = 6,         // Changed fields of the players affected by a turn
+
+    // Client -> server
+    MSG_INPUT = 16,          // Free text answer to a prompt (avatar setup, or typed numbers)
+    MSG_ACTION_REQUEST = 17, // Typed answer to the action/target prompts
+    MSG_RESYNC = 18          // Asks for a new MSG_SNAPSHOT, e.g. after missing a delta
+};
+
+// Channel of a MSG_TEXT message
+enum TextChannel : uint8_t {
+    CHANNEL_SYS = 0,  // Connection and lobby messages
+    CHANNEL_GAME = 1  // Battle narration
+};
+
+// What a MSG_PROMPT is asking for
+enum PromptKind : uint8_t {
+    PROMPT_AVATAR = 0, // "<name> <class>"
+    PROMPT_ACTION = 1, // Action number
+    PROMPT_TARGET = 2  // Target index
+};
+
+// State flags of a player
+enum PlayerFlags : uint8_t {
+    PLAYER_ALIVE = 1,
+    PLAYER_PROTECTED = 2 // Their next incoming attack is blocked
+};
+
+// Fields present in a MSG_DELTA entry, written in this order
+enum PlayerField : uint8_t {
+    FIELD_HEALTH = 1,
+    FIELD_MANA = 2,
+    FIELD_FLAGS = 4,
+    FIELD_BONUS = 8,
+    FIELD_ALL = 15
+};
+
+// Player number of a recipient that is not in the battle
+#define NO_PLAYER 0xFFFFFFFFu
+
+// Flags of a MSG_ACTION_RESULT
+enum ActionResultFlags : uint8_t {
+    RESULT_ERROR = 1,
+    RESULT_AREA = 2 // Area action: target is NO_PLAYER and damage is what each enemy hit took
+};
+
+// A decoded frame. payload points into the buffer the frame was decoded from.
+struct Frame {
+    uint8_t version = 0;
+    uint8_t type = 0;
+    const char *payload = nullptr;
+    uint32_t size = 0;
+};
+
+// Decoded message bodies. string_views point into the frame payload.
+struct TextMessage {
+    uint8_t channel = CHANNEL_SYS;
+    std::string_view text;
+};
+
+struct PromptMessage {
+    uint8_t kind = PROMPT_AVATAR;
+    std::string_view text;
+};
+
+struct ActionResultMessage {
+    uint32_t attacker = 0;
+    uint32_t target = 0;
+    uint8_t action = 0;
+    uint8_t flags = 0;
+    int32_t damage = 0;
+    int32_t heal = 0;
+    std::string_view text;
+};
+
+// One player in a MSG_SNAPSHOT or MSG_DELTA. A delta only carries the fields it lists; name and
+// className are only sent in snapshots.
+struct PlayerState {
+    uint32_t index = 0;
+    std::string_view name;
+    std::string_view className;
+    int32_t health = 0;
+    int32_t mana = 0;
+    uint8_t flags = 0;        // PlayerFlags
+    int32_t attackBonus = 0;  // Percent added to the next attack
+};
+
+struct ActionRequestMessage {
+    int32_t action = -1; // -1 when only answering the target prompt
+    int32_t target = -1; // -1 when only answering the action prompt
+};
+
+// Result of decodeFrame
+enum DecodeStatus {
+    DECODE_OK,
+    DECODE_INCOMPLETE, // Need more bytes
+    DECODE_MALFORMED   // Bad version or oversized payload; the connection should be dropped
+};
+
+// Builds frames by appending to a caller-owned buffer
+class FrameWriter {
+    private:
+        std::string& out;
+        size_t start;
+
+        void put(const void *data, size_t size) { out.append((const char *)data, size); }
+
+    public:
+        // Starts a frame of the given type at the end of out
+        FrameWriter(std::string& out, uint8_t type) : out(out), start(out.size()) {
+            char header[FRAME_HEADER_SIZE] = {0, 0, 0, 0, (char)PROTOCOL_VERSION, (char)type};
+            put(header, sizeof(header));
+        }
+
+        // Patches the payload length into the header
+        ~FrameWriter() {
+            uint32_t size = (uint32_t)(out.size() - start - FRAME_HEADER_SIZE);
+            out[start] = (char)(size >> 24);
+            out[start + 1] = (char)(size >> 16);
+            out[start + 2] = (char)(size >> 8);
+            out[start + 3] = (char)size;
+        }
+
+        FrameWriter(const FrameWriter&) = delete;
+        FrameWriter& operator=(const FrameWriter&) = delete;
+
+        void u8(uint8_t v) { out.push_back((char)v); }
+        void u16(uint16_t v) { char b[2] = {(char)(v >> 8), (char)v}; put(b, 2); }
+        void u32(uint32_t v) { char b[4] = {(char)(v >> 24), (char)(v >> 16), (char)(v >> 8), (char)v}; put(b, 4); }
+        void i32(int32_t v) { u32((uint32_t)v); }
+
+        // Strings longer than 64 KiB are truncated
+        void str(std::string_view s) {
+            size_t size = s.size() > 0xFFFF ? 0xFFFF : s.size();
+            u16((uint16_t)size);
+            put(s.data(), size);
+        }
+};
+
+// Reads fields from a frame payload. A read past the end sets the failed flag and returns zeros.
+class FrameReader {
+    private:
+        const unsigned char *pos;
+        const unsigned char *end;
+        bool failed;
+
+        bool need(size_t n) {
+            if(failed || (size_t)(end - pos) < n) { failed = true; return false; }
+            return true;
+        }
+
+    public:
+        explicit FrameReader(const Frame& frame)
+            : pos((const unsigned char *)frame.payload), end(pos + frame.size), failed(false) {}
+
+        bool ok() const { return !failed; }
+        bool atEnd() const { return pos == end; }
+
+        uint8_t u8() { if(!need(1)) return 0; return *pos++; }
+        uint16_t u16() { if(!need(2)) return 0; uint16_t v = (uint16_t)(pos[0] << 8 | pos[1]); pos += 2; return v; }
+        uint32_t u32() {
+            if(!need(4)) return 0;
+            uint32_t v = (uint32_t)pos[0] << 24 | (uint32_t)pos[1] << 16 | (uint32_t)pos[2] << 8 | pos[3];
+            pos += 4;
+            return v;
+        }
+        int32_t i32() { return (int32_t)u32(); }
+
+        std::string_view str() {
+            uint16_t size = u16();
+            if(!need(size)) return std::string_view();
+            std::string_view s((const char *)pos, size);
+            pos += size;
+            return s;
+        }
+};
+
+// Decodes the frame at the start of data. On DECODE_OK, consumed holds the frame's total size.
+inline DecodeStatus decodeFrame(const char *data, size_t size, Frame& frame, size_t& consumed){
+    if(size < FRAME_HEADER_SIZE) return DECODE_INCOMPLETE;
+
+    const unsigned char *h = (const unsigned char *)data;
+    uint32_t length = (uint32_t)h[0] << 24 | (uint32_t)h[1] << 16 | (uint32_t)h[2] << 8 | h[3];
+    if(h[4] != PROTOCOL_VERSION || length > MAX_FRAME_PAYLOAD) return DECODE_MALFORMED;
+    if(size - FRAME_HEADER_SIZE < length) return DECODE_INCOMPLETE;
+
+    frame.version = h[4];
+    frame.type = h[5];
+    frame.payload = data + FRAME_HEADER_SIZE;
+    frame.size = length;
+    consumed = FRAME_HEADER_SIZE + length;
+    return DECODE_OK;
+}
+
+// Encoders: append one complete frame to out
+inline void encodeText(std::string& out, uint8_t channel, std::string_view text){
+    FrameWriter w(out, MSG_TEXT);
+    w.u8(channel);
+    w.str(text);
+}
+
+inline void encodePrompt(std::string& out, uint8_t kind, std::string_view text){
+    FrameWriter w(out, MSG_PROMPT);
+    w.u8(kind);
+    w.str(text);
+}
+
+inline void encodeActionResult(std::string& out, const ActionResultMessage& msg){
+    FrameWriter w(out, MSG_ACTION_RESULT);
+    w.u32(msg.attacker);
+    w.u32(msg.target);
+    w.u8(msg.action);
+    w.u8(msg.flags);
+    w.i32(msg.damage);
+    w.i32(msg.heal);
+    w.str(msg.text);
+}
+
+// State frames are written entry by entry: call the entry encoder count times after the header.
+// seq numbers the roster states: a delta with seq n applies on top of state n - 1, and a snapshot
+// carries the seq of the state it describes. self is the recipient's player number.
+inline void encodeSnapshotHeader(FrameWriter& w, uint32_t seq, uint32_t self, uint32_t count){
+    w.u32(seq);
+    w.u32(self);
+    w.u32(count);
+}
+
+// Bytes of a snapshot frame before its first entry. A snapshot encoded once can go to many players
+// by sending each a copy of this prefix with its own self, followed by the shared entries.
+#define SNAPSHOT_PREFIX_SIZE (FRAME_HEADER_SIZE + 12)
+
+inline void setSnapshotSelf(std::string& prefix, uint32_t self){
+    size_t at = FRAME_HEADER_SIZE + 4;
+    prefix[at] = (char)(self >> 24);
+    prefix[at + 1] = (char)(self >> 16);
+    prefix[at + 2] = (char)(self >> 8);
+    prefix[at + 3] = (char)self;
+}
+
+inline void encodeSnapshotEntry(FrameWriter& w, const PlayerState& player){
+    w.u32(player.index);
+    w.str(player.name);
+    w.str(player.className);
+    w.i32(player.health);
+    w.i32(player.mana);
+    w.u8(player.flags);
+    w.i32(player.attackBonus);
+}
+
+inline void encodeDeltaHeader(FrameWriter& w, uint32_t seq, uint32_t count){
+    w.u32(seq);
+    w.u32(count);
+}
+
+inline void encodeDeltaEntry(FrameWriter& w, uint8_t fields, const PlayerState& player){
+    w.u32(player.index);
+    w.u8(fields);
+    if(fields & FIELD_HEALTH) w.i32(player.health);
+    if(fields & FIELD_MANA) w.i32(player.mana);
+    if(fields & FIELD_FLAGS) w.u8(player.flags);
+    if(fields & FIELD_BONUS) w.i32(player.attackBonus);
+}
+
+inline void encodeShutdown(std::string& out, std::string_view reason){
+    FrameWriter w(out, MSG_SHUTDOWN);
+    w.str(reason);
+}
+
+inline void encodeInput(std::string& out, std::string_view text){
+    FrameWriter w(out, MSG_INPUT);
+    w.str(text);
+}
+
+inline void encodeActionRequest(std::string& out, const ActionRequestMessage& msg){
+    FrameWriter w(out, MSG_ACTION_REQUEST);
+    w.i32(msg.action);
+    w.i32(msg.target);
+}
+
+inline void encodeResync(std::string& out){
+    FrameWriter w(out, MSG_RESYNC);
+}
+
+// Decoders: return false if the payload is truncated
+inline bool decodeText(const Frame& frame, TextMessage& msg){
+    FrameReader r(frame);
+    msg.channel = r.u8();
+    msg.text = r.str();
+    return r.ok();
+}
+
+inline bool decodePrompt(const Frame& frame, PromptMessage& msg){
+    FrameReader r(frame);
+    msg.kind = r.u8();
+    msg.text = r.str();
+    return r.ok();
+}
+
+inline bool decodeActionResult(const Frame& frame, ActionResultMessage& msg){
+    FrameReader r(frame);
+    msg.attacker = r.u32();
+    msg.target = r.u32();
+    msg.action = r.u8();
+    msg.flags = r.u8();
+    msg.damage = r.i32();
+    msg.heal = r.i32();
+    msg.text = r.str();
+    return r.ok();
+}
+
+// Reads a state header; then call the entry decoder count times with the same reader
+inline bool decodeSnapshotHeader(FrameReader& r, uint32_t& seq, uint32_t& self, uint32_t& count){
+    seq = r.u32();
+    self = r.u32();
+    count = r.u32();
+    return r.ok();
+}
+
+inline bool decodeSnapshotEntry(FrameReader& r, PlayerState& player){
+    player.index = r.u32();
+    player.name = r.str();
+    player.className = r.str();
+    player.health = r.i32();
+    player.mana = r.i32();
+    player.flags = r.u8();
+    player.attackBonus = r.i32();
+    return r.ok();
+}
+
+inline bool decodeDeltaHeader(FrameReader& r, uint32_t& seq, uint32_t& count){
+    seq = r.u32();
+    count = r.u32();
+    return r.ok();
+}
+
+// Only the fields listed in fields are written to player
+inline bool decodeDeltaEntry(FrameReader& r, uint8_t& fields, PlayerState& player){
+    player.index = r.u32();
+    fields = r.u8();
+    if(fields & FIELD_HEALTH) player.health = r.i32();
+    if(fields & FIELD_MANA) player.mana = r.i32();
+    if(fields & FIELD_FLAGS) player.flags = r.u8();
+    if(fields & FIELD_BONUS) player.attackBonus = r.i32();
+    return r.ok();
+}
+
+inline bool decodeShutdown(const Frame& frame, std::string_view& reason){
+    FrameReader r(frame);
+    reason = r.str();
+    return r.ok();
+}
+
+inline bool decodeInput(const Frame& frame, std::string_view& text){
+    FrameReader r(frame);
+    text = r.str();
+    return r.ok();
+}
+
+inline bool decodeActionRequest(const Frame& frame, ActionRequestMessage& msg){
+    FrameReader r(frame);
+    msg.action = r.i32();
+    msg.target = r.i32();
+    return r.ok();
+}
+
+#endif
@@ -0,0 +1,218 @@
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+
+#include "reactor.h"
+
+// Current time in timer wheel ticks
+static uint64_t nowTicks(){
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch());
+    return (uint64_t)ms.count() / TIMEOUT_TICK_MS;
+}
+
+// Constructor: creates the epoll instance and the eventfd other threads wake it with
+Reactor::Reactor() : running(false), nextGeneration(1), wheel(nowTicks()), wheelTimer(-1) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if(epollFd < 0) perror("epoll_create1 failed");
+
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(wakeFd < 0) perror("eventfd failed");
+    else add(wakeFd, EPOLLIN, [this](uint32_t){ onWake(); });
+}
+
+Reactor::~Reactor() {
+    if(wakeFd >= 0) close(wakeFd);
+    if(wheelTimer >= 0) close(wheelTimer);
+    if(epollFd >= 0) close(epollFd);
+}
+
+// Starts watching fd for the given events. The generation is packed next to the fd so
+// stale events for a closed (and possibly reused) fd number are ignored.
+bool Reactor::add(int fd, uint32_t events, EventHandler handler){
+    uint32_t generation = nextGeneration++;
+
+    struct epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = ((uint64_t)generation << 32) | (uint32_t)fd;
+
+    if(epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0){
+        perror("epoll_ctl ADD failed");
+        return false;
+    }
+
+    watches[fd] = std::unique_ptr<Watch>(new Watch{generation, std::move(handler)});
+    return true;
+}
+
+// Changes the event mask of an already watched fd
+bool Reactor::modify(int fd, uint32_t events){
+    auto it = watches.find(fd);
+    if(it == watches.end()) return false;
+
+    struct epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = ((uint64_t)it->second->generation << 32) | (uint32_t)fd;
+
+    if(epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev) < 0){
+        perror("epoll_ctl MOD failed");
+        return false;
+    }
+    return true;
+}
+
+// Stops watching fd. Must be called before the fd is closed.
+void Reactor::remove(int fd){
+    auto it = watches.find(fd);
+    if(it == watches.end()) return;
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+
+    // The handler may be the one currently running, so keep it alive until the batch ends
+    retired.push_back(std::move(it->second));
+    watches.erase(it);
+}
+
+// Creates a disarmed timer; returns its timerfd or -1 on failure
+int Reactor::addTimer(TimerHandler onExpire){
+    int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if(timerFd < 0){
+        perror("timerfd_create failed");
+        return -1;
+    }
+
+    bool ok = add(timerFd, EPOLLIN, [timerFd, onExpire](uint32_t){
+        uint64_t expirations;
+        if(read(timerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) return;
+        onExpire();
+    });
+
+    if(!ok){
+        close(timerFd);
+        return -1;
+    }
+    return timerFd;
+}
+
+// Arms (or re-arms) a timer to fire after intervalMs, optionally repeating
+bool Reactor::armTimer(int timerFd, int intervalMs, bool periodic){
+    struct itimerspec spec{};
+    spec.it_value.tv_sec = intervalMs / 1000;
+    spec.it_value.tv_nsec = (long)(intervalMs % 1000) * 1000000L;
+    if(periodic) spec.it_interval = spec.it_value;
+
+    if(timerfd_settime(timerFd, 0, &spec, nullptr) < 0){
+        perror("timerfd_settime failed");
+        return false;
+    }
+    return true;
+}
+
+void Reactor::removeTimer(int timerFd){
+    if(timerFd < 0) return;
+    remove(timerFd);
+    close(timerFd);
+}
+
+// Adds a timeout to the wheel, starting the wheel's tick timer if it was idle
+TimeoutId Reactor::scheduleTimeout(int delayMs, TimerHandler onExpire){
+    if(wheelTimer < 0){
+        wheelTimer = addTimer([this](){ onWheelTick(); });
+        if(wheelTimer < 0) return 0;
+    }
+
+    bool wasIdle = wheel.empty();
+    if(wasIdle) wheel.advance(nowTicks()); // Only catches up the clock, nothing is pending
+
+    uint64_t ticks = ((uint64_t)std::max(delayMs, 0) + TIMEOUT_TICK_MS - 1) / TIMEOUT_TICK_MS;
+    TimeoutId id = wheel.schedule(ticks, std::move(onExpire));
+
+    if(wasIdle) armTimer(wheelTimer, TIMEOUT_TICK_MS, true);
+    return id;
+}
+
+bool Reactor::cancelTimeout(TimeoutId id){
+    if(id == 0 || !wheel.cancel(id)) return false;
+    if(wheel.empty()) armTimer(wheelTimer, 0, false);
+    return true;
+}
+
+// Runs the timeouts that are due and stops ticking once none are left
+void Reactor::onWheelTick(){
+    wheel.advance(nowTicks());
+    if(wheel.empty()) armTimer(wheelTimer, 0, false);
+}
+
+// Dispatches ready events until stop() is called
+void Reactor::run(){
+    struct epoll_event events[256];
+    running = true;
+
+    while(running){
+        int n = epoll_wait(epollFd, events, 256, -1);
+        if(n < 0){
+            if(errno == EINTR) continue;
+            perror("epoll_wait failed");
+            break;
+        }
+
+        for(int i = 0; i < n && running; i++){
+            int fd = (int)(uint32_t)events[i].data.u64;
+            uint32_t generation = (uint32_t)(events[i].data.u64 >> 32);
+
+            auto it = watches.find(fd);
+            if(it == watches.end() || it->second->generation != generation) continue;
+
+            it->second->handler(events[i].events);
+        }
+
+        retired.clear();
+
+        // Deferred tasks may queue more work, so drain until nothing is left
+        while(!deferred.empty()){
+            std::vector<std::function<void()>> tasks;
+            tasks.swap(deferred);
+            for(auto& task : tasks) task();
+        }
+        retired.clear();
+    }
+}
+
+void Reactor::defer(std::function<void()> task){
+    deferred.push_back(std::move(task));
+}
+
+// Only the first task posted since the last wakeup writes the eventfd
+void Reactor::post(std::function<void()> task){
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(postedMutex);
+        wasEmpty = posted.empty();
+        posted.push_back(std::move(task));
+    }
+
+    uint64_t one = 1;
+    if(wasEmpty && write(wakeFd, &one, sizeof(one)) < 0) perror("eventfd write failed");
+}
+
+// Runs the tasks other threads posted. The eventfd is read before the queue is taken, so a task
+// posted meanwhile either makes it into this batch or wakes the loop again.
+void Reactor::onWake(){
+    uint64_t count;
+    if(read(wakeFd, &count, sizeof(count)) < 0 && errno != EAGAIN) perror("eventfd read failed");
+
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(postedMutex);
+        tasks.swap(posted);
+    }
+    for(auto& task : tasks) task();
+}
+
+void Reactor::stop(){
+    running = false;
+}
@@ -0,0 +1,82 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "timerwheel.h"
+
+// Callback invoked with the epoll event mask when a watched fd becomes ready
+using EventHandler = std::function<void(uint32_t events)>;
+
+// Callback invoked when a timer expires
+using TimerHandler = std::function<void()>;
+
+// Resolution of the timeouts kept in the reactor's timer wheel
+#define TIMEOUT_TICK_MS 10
+
+// Single-threaded epoll event loop. Every fd (listening socket, clients and timerfds)
+// is registered here and the loop only wakes up on readiness or timer expiry. post() is the only
+// method other threads may call.
+class Reactor {
+    private:
+        struct Watch {
+            uint32_t generation;  // Distinguishes a reused fd number from a removed one
+            EventHandler handler;
+        };
+
+        int epollFd;
+        bool running;
+        uint32_t nextGeneration;
+        std::unordered_map<int, std::unique_ptr<Watch>> watches;
+        std::vector<std::unique_ptr<Watch>> retired; // Watches removed mid-dispatch, freed after the batch
+        std::vector<std::function<void()>> deferred; // Work queued to run once the current batch is done
+
+        TimerWheel wheel; // Timeouts, driven by one timerfd that only ticks while any are pending
+        int wheelTimer;
+
+        int wakeFd;                                // eventfd written by post() to wake the loop
+        std::mutex postedMutex;                    // Guards posted, the only state shared with other threads
+        std::vector<std::function<void()>> posted; // Tasks handed over by other threads
+
+        void onWheelTick();
+        void onWake();
+
+    public:
+        Reactor();
+        ~Reactor();
+
+        Reactor(const Reactor&) = delete;
+        Reactor& operator=(const Reactor&) = delete;
+
+        // Fd registration
+        bool add(int fd, uint32_t events, EventHandler handler);
+        bool modify(int fd, uint32_t events);
+        void remove(int fd);
+
+        // Timers (timerfd based). A zero interval disarms the timer.
+        int addTimer(TimerHandler onExpire);
+        bool armTimer(int timerFd, int intervalMs, bool periodic);
+        void removeTimer(int timerFd);
+
+        // Timeouts (timer wheel based): cheap one-shot deadlines, for when there are many of them.
+        // The handler runs within TIMEOUT_TICK_MS after delayMs.
+        TimeoutId scheduleTimeout(int delayMs, TimerHandler onExpire);
+        bool cancelTimeout(TimeoutId id);
+
+        // Runs task after the current batch of events, outside of any handler
+        void defer(std::function<void()> task);
+
+        // Runs task on the loop's thread. Safe to call from any thread.
+        void post(std::function<void()> task);
+
+        // Loop control
+        void run();
+        void stop();
+};
+
+#endif
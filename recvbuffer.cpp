@@ -0,0 +1,87 @@
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#include "recvbuffer.h"
+#include "metrics.h"
+
+// Constructor: allocates capacity bytes up front
+RecvBuffer::RecvBuffer(size_t capacity, size_t maxCapacity)
+    : data(new char[capacity]), capacity(capacity), maxCapacity(maxCapacity > capacity ? maxCapacity : capacity),
+      readPos(0), writePos(0) {}
+
+// Moves unread bytes to the front so the free space is one contiguous block
+void RecvBuffer::compact(){
+    if(readPos == 0) return;
+
+    size_t unread = writePos - readPos;
+    if(unread > 0) memmove(data.get(), data.get() + readPos, unread);
+    readPos = 0;
+    writePos = unread;
+}
+
+// Doubles the buffer, up to maxCapacity. Returns false if it is already that big.
+bool RecvBuffer::grow(){
+    if(capacity >= maxCapacity) return false;
+
+    size_t bigger = capacity * 2 < maxCapacity ? capacity * 2 : maxCapacity;
+    std::unique_ptr<char[]> moved(new char[bigger]);
+    memcpy(moved.get(), data.get() + readPos, writePos - readPos);
+    writePos -= readPos;
+    readPos = 0;
+    data = std::move(moved);
+    capacity = bigger;
+    return true;
+}
+
+FillStatus RecvBuffer::fill(int fd, IoCounters *counters){
+    if(readPos == writePos) readPos = writePos = 0;
+    else if(writePos == capacity) compact();
+
+    if(writePos == capacity && !grow()) return FILL_OVERFLOW;
+
+    while(true){
+        ssize_t n = read(fd, data.get() + writePos, capacity - writePos);
+        if(counters){
+            counters->calls.add();
+            if(n > 0) counters->bytes.add((uint64_t)n);
+        }
+        if(n > 0){
+            writePos += (size_t)n;
+            return FILL_OK;
+        }
+        if(n == 0) return FILL_CLOSED;
+        if(errno == EINTR) continue;
+        if(errno == EAGAIN || errno == EWOULDBLOCK) return FILL_OK;
+        return FILL_ERROR;
+    }
+}
+
+DecodeStatus RecvBuffer::nextFrame(Frame& frame){
+    size_t size;
+    DecodeStatus status = decodeFrame(data.get() + readPos, writePos - readPos, frame, size);
+
+    if(status == DECODE_OK){
+        readPos += size;
+        return DECODE_OK;
+    }
+
+    // A frame bigger than the buffer can ever be can never complete
+    if(status == DECODE_INCOMPLETE && writePos - readPos >= FRAME_HEADER_SIZE){
+        const unsigned char *h = (const unsigned char *)data.get() + readPos;
+        size_t length = (size_t)h[0] << 24 | (size_t)h[1] << 16 | (size_t)h[2] << 8 | h[3];
+        if(FRAME_HEADER_SIZE + length > maxCapacity) return DECODE_MALFORMED;
+    }
+    return status;
+}
+
+DecodeStatus RecvBuffer::nextLine(std::string_view& line){
+    const char *start = data.get() + readPos;
+    const char *end = (const char *)memchr(start, '\n', writePos - readPos);
+
+    if(end == nullptr) return writePos - readPos >= maxCapacity ? DECODE_MALFORMED : DECODE_INCOMPLETE;
+
+    line = std::string_view(start, (size_t)(end - start));
+    readPos += line.size() + 1;
+    return DECODE_OK;
+}
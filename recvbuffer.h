@@ -0,0 +1,59 @@
+#ifndef RECVBUFFER_H
+#define RECVBUFFER_H
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+#include "protocol.h"
+
+struct IoCounters;
+
+// Result of RecvBuffer::fill
+enum FillStatus {
+    FILL_OK,       // Read something, or nothing was available
+    FILL_CLOSED,   // Peer closed the connection
+    FILL_ERROR,    // recv failed
+    FILL_OVERFLOW  // Buffer is full and nothing in it was consumed: the peer is misbehaving
+};
+
+// Receive buffer for one connection. Each fill() is a single read() that takes as much as the
+// kernel has (up to the free space); complete frames or lines are then handed back as views into
+// the buffer, without copying. Unread bytes are slid back to the front only when the free tail
+// runs out, so the buffer behaves like a ring that is always contiguous to readers. When even that
+// leaves no room, a buffer with a larger maxCapacity doubles in size; the server keeps the
+// default (no growth) so a client can never make it allocate more.
+//
+// Views returned by nextFrame()/nextLine() stay valid until the next fill() or clear().
+class RecvBuffer {
+    private:
+        std::unique_ptr<char[]> data;
+        size_t capacity;
+        size_t maxCapacity;
+        size_t readPos;  // First unread byte
+        size_t writePos; // One past the last received byte
+
+        void compact();
+        bool grow();
+
+    public:
+        explicit RecvBuffer(size_t capacity, size_t maxCapacity = 0); // 0: never grows past capacity
+
+        // Reads once from fd (a socket, pipe or terminal) into the free space; counters, if given,
+        // receive the syscall and bytes
+        FillStatus fill(int fd, IoCounters *counters = nullptr);
+
+        // Extracts the next complete frame. DECODE_MALFORMED also covers frames that could never
+        // fit in this buffer.
+        DecodeStatus nextFrame(Frame& frame);
+
+        // Extracts the next '\n' terminated line (without the terminator). DECODE_MALFORMED means
+        // the line is longer than the buffer can hold.
+        DecodeStatus nextLine(std::string_view& line);
+
+        size_t size() const { return writePos - readPos; }
+        bool empty() const { return readPos == writePos; }
+        void clear() { readPos = writePos = 0; }
+};
+
+#endif
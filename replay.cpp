@@ -0,0 +1,155 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "controller.h"
+#include "journal.h"
+#include "characters/actiontext.h"
+
+// Re-runs recorded battles through the Controller and checks every action reproduces the
+// journaled outcome. A mismatch means the game rules changed since the journal was written.
+
+static const char* ACTION_NAMES[] = {"ATTACK", "CAST_SPELL", "SPECIAL_MOVE", "AREA_ATTACK"};
+
+static void usage(const char *prog){
+    std::cerr << "Usage: " << prog << " [-v] journal...\n"
+              << "  -v   print every replayed action\n";
+}
+
+struct ReplayStats {
+    uint64_t turns = 0;
+    uint64_t mismatches = 0;
+};
+
+// Replays one journal; returns false if it could not be read
+static bool replayFile(const std::string& path, bool verbose, ReplayStats& total){
+    JournalReader reader;
+    std::string error;
+    if(!reader.open(path, error)){
+        std::cerr << path << ": " << error << "\n";
+        return false;
+    }
+
+    std::vector<AnyCharacter> owned;
+    std::vector<Character *> players;
+    owned.reserve(reader.players.size());
+    for(const JournalPlayer& p : reader.players){
+        players.push_back(&emplaceCharacter(owned, p.classId, p.name));
+    }
+
+    Controller controller(players, reader.seed);
+    uint64_t turns = 0, mismatches = 0;
+    bool ended = false;
+    int recordedWinner = -1;
+    std::string text; // Narration of the current action, for -v
+
+    JournalRecord record;
+    while(!ended && reader.next(record)){
+        if(record.type == JOURNAL_DISCONNECT){
+            if(record.attacker >= players.size()){
+                std::cerr << path << ": disconnected player out of range at turn " << turns << "\n";
+                return false;
+            }
+            players[record.attacker]->setDead();
+            if(verbose) std::cout << "  " << reader.players[record.attacker].name << " disconnected\n";
+            continue;
+        }
+        if(record.type == JOURNAL_END){
+            ended = true;
+            recordedWinner = record.winner;
+            continue;
+        }
+
+        bool area = record.target == JOURNAL_NO_TARGET;
+        if(record.attacker >= players.size() || (!area && record.target >= players.size())){
+            std::cerr << path << ": player out of range at turn " << turns << "\n";
+            return false;
+        }
+
+        Character *attacker = players[record.attacker];
+        Character *target = area ? nullptr : players[record.target];
+        ActionResult result = controller.applyAction(attacker, record.action, target);
+        turns++;
+
+        bool matches = result.damage == record.damage && result.heal == record.heal &&
+                       result.isError() == ((record.flags & JOURNAL_FLAG_ERROR) != 0);
+        if(!matches){
+            mismatches++;
+            std::cout << "  turn " << turns << ": recorded damage " << record.damage << " heal " << record.heal
+                      << ", replayed damage " << result.damage << " heal " << result.heal << "\n";
+        }
+        else if(verbose){
+            text.clear();
+            appendActionText(text, attacker->getName(), area ? "" : target->getName(), result);
+            std::cout << "  " << attacker->getName() << " -> " << (area ? "all" : target->getName()) << " "
+                      << (record.action < ACTION_COUNT ? ACTION_NAMES[record.action] : "?") << ": " << text << "\n";
+        }
+    }
+
+    // A journal holds exactly one battle: anything the reader stopped on, or anything after the
+    // end record, means the file is corrupt or was appended to
+    if(!reader.atEnd()){
+        std::cerr << path << ": " << (ended ? "data after the end record" : "unreadable record") << " after turn " << turns << "\n";
+        return false;
+    }
+
+    int winner = -1, alive = 0;
+    for(size_t i = 0; i < players.size(); i++){
+        if(players[i]->isAlive()){
+            winner = (int)i;
+            alive++;
+        }
+    }
+    if(alive != 1) winner = -1;
+
+    std::cout << path << ": seed " << reader.seed << ", " << players.size() << " players, " << turns << " actions, ";
+    if(!ended) std::cout << "incomplete (no end record)";
+    else if(winner != recordedWinner){
+        mismatches++;
+        std::cout << "winner mismatch (recorded " << recordedWinner << ", replayed " << winner << ")";
+    }
+    else if(winner >= 0) std::cout << "winner " << players[winner]->getName();
+    else std::cout << "no winner";
+    std::cout << (mismatches ? ", " + std::to_string(mismatches) + " MISMATCHES" : ", OK") << "\n";
+
+    total.turns += turns;
+    total.mismatches += mismatches;
+    return true;
+}
+
+int main(int argc, char *argv[]){
+    bool verbose = false;
+    std::vector<std::string> paths;
+
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "-v") verbose = true;
+        else if(arg == "-h" || arg == "--help"){
+            usage(argv[0]);
+            return 0;
+        }
+        else paths.push_back(arg);
+    }
+    if(paths.empty()){
+        usage(argv[0]);
+        return 1;
+    }
+
+    ReplayStats total;
+    int failed = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for(const std::string& path : paths){
+        if(!replayFile(path, verbose, total)) failed++;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "\nReplayed " << paths.size() - failed << " journal(s), " << total.turns << " actions in "
+              << std::fixed << std::setprecision(3) << seconds << "s";
+    if(seconds > 0) std::cout << " (" << std::setprecision(0) << total.turns / seconds << " actions/s)";
+    std::cout << ", " << total.mismatches << " mismatch(es)\n";
+
+    return failed || total.mismatches ? 1 : 0;
+}
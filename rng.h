@@ -0,0 +1,55 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// Small, fast, seedable generator (xoshiro256**). Each match or simulated battle owns one, so
+// nothing is shared between threads and the same seed replays the same battle anywhere.
+class Rng {
+    private:
+        uint64_t s[4];
+
+        static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    public:
+        explicit Rng(uint64_t seed = 0) { reseed(seed); }
+
+        // Expands a 64 bit seed into the full state with splitmix64
+        void reseed(uint64_t seed) {
+            for(int i = 0; i < 4; i++) s[i] = splitmix64(seed);
+        }
+
+        uint64_t next() {
+            uint64_t result = rotl(s[1] * 5, 7) * 9;
+            uint64_t t = s[1] << 17;
+
+            s[2] ^= s[0];
+            s[3] ^= s[1];
+            s[1] ^= s[2];
+            s[0] ^= s[3];
+            s[2] ^= t;
+            s[3] = rotl(s[3], 45);
+
+            return result;
+        }
+
+        // Uniform integer in [0, n), n > 0 (multiply-shift, no division)
+        uint32_t below(uint32_t n) {
+            return (uint32_t)(((next() >> 32) * (uint64_t)n) >> 32);
+        }
+
+        // Uniform integer in [lo, hi]
+        int range(int lo, int hi) {
+            return lo + (int)below((uint32_t)(hi - lo + 1));
+        }
+
+        // One splitmix64 step; also handy to derive independent seeds from a base seed
+        static uint64_t splitmix64(uint64_t& state) {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <cerrno>
+
+#include "sendqueue.h"
+#include "metrics.h"
+
+// Number of queued payloads gathered into a single writev
+static const int MAX_IOVECS = 64;
+
+void SendQueue::push(Payload payload){
+    if(abandoned || !payload || payload->empty()) return;
+    queuedBytes += payload->size();
+    chunks.push_back(std::move(payload));
+}
+
+FlushStatus SendQueue::flush(int fd, IoCounters *counters){
+    while(!chunks.empty()){
+        struct iovec iov[MAX_IOVECS];
+        int count = 0;
+
+        for(auto it = chunks.begin(); it != chunks.end() && count < MAX_IOVECS; ++it, ++count){
+            size_t offset = count == 0 ? headOffset : 0;
+            iov[count].iov_base = (void *)((*it)->data() + offset);
+            iov[count].iov_len = (*it)->size() - offset;
+        }
+
+        struct msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if(counters){
+            counters->calls.add();
+            if(n > 0) counters->bytes.add((uint64_t)n);
+        }
+        if(n < 0){
+            if(errno == EINTR) continue;
+            if(errno == EAGAIN || errno == EWOULDBLOCK) return FLUSH_PENDING;
+            return FLUSH_ERROR;
+        }
+
+        // Drops fully written payloads and remembers how far into the next one we got
+        size_t written = (size_t)n;
+        queuedBytes -= written;
+        while(written > 0){
+            size_t left = chunks.front()->size() - headOffset;
+            if(written < left){
+                headOffset += written;
+                break;
+            }
+            written -= left;
+            chunks.pop_front();
+            headOffset = 0;
+        }
+    }
+    return FLUSH_DONE;
+}
+
+void SendQueue::clear(){
+    chunks.clear();
+    headOffset = 0;
+    queuedBytes = 0;
+}
@@ -0,0 +1,56 @@
+#ifndef SENDQUEUE_H
+#define SENDQUEUE_H
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+// Immutable, reference-counted bytes. A broadcast is encoded once into a Payload and the same
+// buffer is queued on every recipient.
+using Payload = std::shared_ptr<const std::pmr::string>;
+
+// Copies bytes into a payload whose reference count and buffer both come from memory
+inline Payload makePayload(std::string_view bytes, std::pmr::memory_resource *memory = std::pmr::get_default_resource()){
+    return std::allocate_shared<std::pmr::string>(std::pmr::polymorphic_allocator<char>(memory), bytes);
+}
+
+struct IoCounters;
+
+// Result of SendQueue::flush
+enum FlushStatus {
+    FLUSH_DONE,    // Everything was written
+    FLUSH_PENDING, // The socket is full, wait for EPOLLOUT
+    FLUSH_ERROR    // send failed, the connection is unusable
+};
+
+// Per-connection output queue. Payloads are written with writev in as few syscalls as the
+// socket allows; whatever does not fit waits for the socket to become writable again.
+class SendQueue {
+    private:
+        std::pmr::deque<Payload> chunks;
+        size_t headOffset;  // Bytes of chunks.front() already written
+        size_t queuedBytes; // Bytes still waiting to be written
+        bool abandoned;     // The connection is being dropped, nothing more is queued
+
+    public:
+        // Queue nodes come from memory, e.g. the arena of the match the connection belongs to
+        explicit SendQueue(std::pmr::memory_resource *memory = std::pmr::get_default_resource())
+            : chunks(memory), headOffset(0), queuedBytes(0), abandoned(false) {}
+
+        void push(Payload payload);
+        // Writes as much as fd accepts; counters, if given, receive the syscalls and bytes
+        FlushStatus flush(int fd, IoCounters *counters = nullptr);
+        void clear();
+
+        // Discards queued data and ignores later pushes
+        void abandon() { clear(); abandoned = true; }
+        bool isAbandoned() const { return abandoned; }
+
+        bool empty() const { return chunks.empty(); }
+        size_t size() const { return queuedBytes; }
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "serverconfig.h"
+
+// Parses a whole decimal number between min and max
+static bool parseInt(const std::string& text, long min, long max, long& value){
+    if(text.empty()) return false;
+
+    char *end;
+    errno = 0;
+    value = strtol(text.c_str(), &end, 10);
+    return errno == 0 && *end == '\0' && value >= min && value <= max;
+}
+
+// A setting: numeric ones are range-checked, text ones are taken as is
+struct ConfigKey {
+    const char *key;
+    const char *help;
+    bool isText;
+    long min, max;
+    void (*set)(ServerConfig&, long, const std::string&);
+};
+
+static const ConfigKey CONFIG_KEYS[] = {
+    {"port", "TCP port for players", false, 1, 65535,
+        [](ServerConfig& c, long v, const std::string&){ c.port = (int)v; }},
+    {"max-players", "players per battle; a full lobby starts at once", false, 2, 1000000,
+        [](ServerConfig& c, long v, const std::string&){ c.maxPlayers = (int)v; }},
+    {"min-players", "players needed to start the lobby countdown", false, 2, 1000000,
+        [](ServerConfig& c, long v, const std::string&){ c.minPlayers = (int)v; }},
+    {"lobby-time", "countdown seconds after the last join", false, 0, 3600,
+        [](ServerConfig& c, long v, const std::string&){ c.lobbyTime = (int)v; }},
+    {"workers", "event loop threads, 0 = one per core", false, 0, 1024,
+        [](ServerConfig& c, long v, const std::string&){ c.workerThreads = (int)v; }},
+    {"backlog", "pending connections on the listening socket (capped by net.core.somaxconn)", false, 1, INT_MAX,
+        [](ServerConfig& c, long v, const std::string&){ c.listenBacklog = (int)v; }},
+    {"accept-burst", "connections accepted per wakeup", false, 1, 1000000,
+        [](ServerConfig& c, long v, const std::string&){ c.acceptBurst = (int)v; }},
+    {"send-high-water", "queued output bytes after which a slow client is dropped", false, 1024, LONG_MAX,
+        [](ServerConfig& c, long v, const std::string&){ c.sendHighWater = (size_t)v; }},
+    {"turn-timeout", "seconds to finish a turn, 0 = no limit", false, 0, 86400,
+        [](ServerConfig& c, long v, const std::string&){ c.turnTimeout = (int)v; }},
+    {"turn-autoplay", "on timeout: 1 = attack the weakest enemy, 0 = skip the turn", false, 0, 1,
+        [](ServerConfig& c, long v, const std::string&){ c.turnTimeoutAutoplay = v != 0; }},
+    {"round-mode", "1 = all players choose at once and each round resolves together, 0 = one turn at a time", false, 0, 1,
+        [](ServerConfig& c, long v, const std::string&){ c.roundMode = v != 0; }},
+    {"stats-port", "metrics over HTTP on 127.0.0.1, 0 = disabled", false, 0, 65535,
+        [](ServerConfig& c, long v, const std::string&){ c.statsPort = (int)v; }},
+    {"journal-dir", "directory for battle journals, \"\" = disabled", true, 0, 0,
+        [](ServerConfig& c, long, const std::string& s){ c.journalDir = s; }},
+};
+
+bool setConfigValue(ServerConfig& config, const std::string& key, const std::string& value, std::string& error){
+    for(const ConfigKey& k : CONFIG_KEYS){
+        if(key != k.key) continue;
+
+        long number = 0;
+        if(!k.isText && !parseInt(value, k.min, k.max, number)){
+            error = key + " must be a number between " + std::to_string(k.min) + " and " + std::to_string(k.max);
+            return false;
+        }
+        k.set(config, number, value);
+        return true;
+    }
+
+    error = "unknown setting '" + key + "'";
+    return false;
+}
+
+static std::string trim(const std::string& text){
+    size_t start = text.find_first_not_of(" \t\r");
+    if(start == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(start, end - start + 1);
+}
+
+bool loadConfigFile(const std::string& path, ServerConfig& config, std::string& error){
+    std::ifstream file(path);
+    if(!file){
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while(std::getline(file, line)){
+        lineNumber++;
+        size_t comment = line.find('#');
+        if(comment != std::string::npos) line.resize(comment);
+        line = trim(line);
+        if(line.empty()) continue;
+
+        size_t eq = line.find('=');
+        if(eq == std::string::npos){
+            error = path + ":" + std::to_string(lineNumber) + ": expected key = value";
+            return false;
+        }
+
+        std::string value = trim(line.substr(eq + 1));
+        if(value.size() >= 2 && value.front() == '"' && value.back() == '"') value = value.substr(1, value.size() - 2);
+
+        std::string keyError;
+        if(!setConfigValue(config, trim(line.substr(0, eq)), value, keyError)){
+            error = path + ":" + std::to_string(lineNumber) + ": " + keyError;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool validateConfig(const ServerConfig& config, std::string& error){
+    if(config.minPlayers > config.maxPlayers){
+        error = "min-players (" + std::to_string(config.minPlayers) + ") is larger than max-players ("
+                + std::to_string(config.maxPlayers) + ")";
+        return false;
+    }
+    if(config.statsPort != 0 && config.statsPort == config.port){
+        error = "stats-port and port are the same";
+        return false;
+    }
+    return true;
+}
+
+std::string configHelp(){
+    std::ostringstream out;
+    for(const ConfigKey& k : CONFIG_KEYS){
+        std::string flag = std::string("--") + k.key + " " + (k.isText ? "TEXT" : "N");
+        out << "  " << flag << std::string(flag.size() < 22 ? 22 - flag.size() : 1, ' ') << k.help << "\n";
+    }
+    return out.str();
+}
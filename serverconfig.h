@@ -0,0 +1,41 @@
+#ifndef SERVERCONFIG_H
+#define SERVERCONFIG_H
+
+#include <cstddef>
+#include <string>
+
+#include "constants.h"
+
+// Server settings. The defaults come from constants.h; a config file and then command line flags
+// override them. Both use the same keys: "max-players = 500" in the file, --max-players 500 on
+// the command line.
+struct ServerConfig {
+    int port = PORT;
+    int maxPlayers = MAX_PLAYERS;
+    int minPlayers = MIN_PLAYERS;
+    int lobbyTime = LOBBY_TIME;           // Seconds
+    int workerThreads = WORKER_THREADS;   // 0 = one per core
+    int listenBacklog = LISTEN_BACKLOG;   // Pending connections on the listening socket
+    int acceptBurst = ACCEPT_BURST;       // Connections accepted per wakeup
+    size_t sendHighWater = SEND_HIGH_WATER;
+    int turnTimeout = TURN_TIMEOUT;       // Seconds, 0 = no limit
+    bool turnTimeoutAutoplay = TURN_TIMEOUT_AUTOPLAY;
+    bool roundMode = ROUND_MODE;          // Everyone chooses at once; turnTimeout is the round deadline
+    int statsPort = STATS_PORT;           // 0 = disabled
+    std::string journalDir = JOURNAL_DIR; // "" = disabled
+};
+
+// Reads "key = value" lines; '#' starts a comment. Returns false with a message in error on an
+// unreadable file, unknown key or bad value.
+bool loadConfigFile(const std::string& path, ServerConfig& config, std::string& error);
+
+// Applies one setting by key. Returns false with a message in error if it is not valid.
+bool setConfigValue(ServerConfig& config, const std::string& key, const std::string& value, std::string& error);
+
+// Checks that the settings make sense together (e.g. min-players <= max-players)
+bool validateConfig(const ServerConfig& config, std::string& error);
+
+// Lines describing every key, for usage messages
+std::string configHelp();
+
+#endif
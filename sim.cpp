@@ -0,0 +1,102 @@
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "simulation.h"
+
+static void usage(const char *prog){
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --roster \"3 Orc, 2 Mage, 1 Halfling\"   players in turn order (default \"1 Orc, 1 Mage, 1 Halfling\")\n"
+              << "  --policy random|attack|focus[,...]    one per player; the last one repeats (default random)\n"
+              << "  --battles N                           battles to run (default 100000)\n"
+              << "  --threads N                           worker threads, 0 = one per core (default 0)\n"
+              << "  --seed N                              fixed seed, 0 = from the clock (default 0)\n";
+}
+
+int main(int argc, char *argv[]){
+    std::string rosterText = "1 Orc, 1 Mage, 1 Halfling";
+    std::string policyText = "random";
+    SimulationConfig config;
+    config.battles = 100000;
+
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if(arg == "--roster" && hasValue) rosterText = argv[++i];
+        else if(arg == "--policy" && hasValue) policyText = argv[++i];
+        else if(arg == "--battles" && hasValue) config.battles = strtoull(argv[++i], nullptr, 10);
+        else if(arg == "--threads" && hasValue) config.threads = atoi(argv[++i]);
+        else if(arg == "--seed" && hasValue) config.seed = strtoull(argv[++i], nullptr, 10);
+        else{
+            usage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+    if(config.battles < 1){
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::string error;
+    if(!parseRoster(rosterText, config.roster, error)){
+        std::cerr << "Invalid roster: " << error << "\n";
+        return 1;
+    }
+
+    // One policy per player; a shorter list repeats its last entry
+    std::stringstream policies(policyText);
+    std::string name;
+    while(std::getline(policies, name, ',')){
+        Policy policy;
+        if(!parsePolicy(name, policy)){
+            std::cerr << "Unknown policy '" << name << "'\n";
+            return 1;
+        }
+        config.policies.push_back(policy);
+    }
+    if(config.policies.empty()) config.policies.push_back(POLICY_RANDOM);
+    config.policies.resize(config.roster.size(), config.policies.back());
+
+    SimulationReport report = runSimulation(config);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Battles: " << report.battles << " in " << report.seconds << "s ("
+              << std::setprecision(0) << report.battles / report.seconds << " battles/s, "
+              << report.battles / report.seconds * 60 << " battles/min)\n" << std::setprecision(2);
+    std::cout << "Seed: " << report.seed << " (pass --seed to reproduce)\n";
+
+    // Win rate per player slot, then aggregated per class
+    std::cout << "\nWin rate per player:\n";
+    uint64_t classWins[CLASS_COUNT] = {0};
+    int classPlayers[CLASS_COUNT] = {0};
+    for(size_t i = 0; i < config.roster.size(); i++){
+        classWins[config.roster[i]] += report.wins[i];
+        classPlayers[config.roster[i]]++;
+        std::cout << "  " << std::setw(3) << i << "  " << std::setw(10) << std::left << className(config.roster[i])
+                  << std::setw(7) << policyName(config.policies[i]) << std::right
+                  << std::setw(7) << 100.0 * report.wins[i] / report.battles << "%\n";
+    }
+
+    std::cout << "\nWin rate per class:\n";
+    for(int c = 0; c < CLASS_COUNT; c++){
+        if(classPlayers[c] == 0) continue;
+        std::cout << "  " << std::setw(10) << std::left << className((ClassId)c) << std::right
+                  << std::setw(7) << 100.0 * classWins[c] / report.battles << "%  ("
+                  << classPlayers[c] << " player(s))\n";
+    }
+    std::cout << "  " << std::setw(10) << std::left << "Draw" << std::right
+              << std::setw(7) << 100.0 * report.draws / report.battles << "%\n";
+
+    std::cout << "\nActions per battle: mean " << report.meanTurns()
+              << ", min " << report.turnPercentile(0)
+              << ", p50 " << report.turnPercentile(0.50)
+              << ", p90 " << report.turnPercentile(0.90)
+              << ", p99 " << report.turnPercentile(0.99)
+              << ", max " << report.turnPercentile(1.0) << "\n";
+
+    return 0;
+}
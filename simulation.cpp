@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <sstream>
+#include <thread>
+
+#include "simulation.h"
+#include "controller.h"
+
+static const char* POLICY_NAMES[POLICY_COUNT] = {"random", "attack", "focus"};
+
+static std::string trim(const std::string& s){
+    size_t start = s.find_first_not_of(" \t");
+    if(start == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t");
+    return s.substr(start, end - start + 1);
+}
+
+bool parseRoster(const std::string& text, std::vector<ClassId>& roster, std::string& error){
+    roster.clear();
+
+    std::stringstream groups(text);
+    std::string group;
+    while(std::getline(groups, group, ',')){
+        group = trim(group);
+        if(group.empty()) continue;
+
+        // "<count> <Class>" or just "<Class>"
+        int count = 1;
+        std::string classType = group;
+        if(isdigit((unsigned char)group[0])){
+            std::istringstream iss(group);
+            iss >> count >> classType;
+        }
+
+        ClassId id;
+        if(!parseClassName(classType, id)){
+            error = "unknown class '" + classType + "'";
+            return false;
+        }
+        if(count <= 0){
+            error = "invalid count in '" + group + "'";
+            return false;
+        }
+        roster.insert(roster.end(), count, id);
+    }
+
+    if(roster.size() < 2){
+        error = "a battle needs at least 2 players";
+        return false;
+    }
+    return true;
+}
+
+bool parsePolicy(const std::string& name, Policy& policy){
+    for(int i = 0; i < POLICY_COUNT; i++){
+        if(name == POLICY_NAMES[i]){
+            policy = (Policy)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* policyName(Policy policy){
+    return POLICY_NAMES[policy];
+}
+
+// Picks the action and target for the current player according to its policy
+static void choose(Policy policy, const std::vector<Character *>& players, Character *self,
+                   Rng& rng, int& action, int& target){
+    if(policy == POLICY_FOCUS){
+        action = SPECIAL_MOVE;
+        target = -1;
+        for(size_t i = 0; i < players.size(); i++){
+            if(players[i] == self || !players[i]->isAlive()) continue;
+            if(target < 0 || players[i]->getHealth() < players[target]->getHealth()) target = (int)i;
+        }
+        return;
+    }
+
+    action = policy == POLICY_ATTACK ? ATTACK : (int)rng.below(ACTION_COUNT);
+
+    // Uniform choice among living enemies without building a list
+    int candidates = 0;
+    for(Character *c : players) if(c != self && c->isAlive()) candidates++;
+
+    int pick = (int)rng.below((uint32_t)candidates);
+    for(size_t i = 0; i < players.size(); i++){
+        if(players[i] == self || !players[i]->isAlive()) continue;
+        if(pick-- == 0){
+            target = (int)i;
+            return;
+        }
+    }
+}
+
+uint64_t battleSeed(uint64_t seed, uint64_t battle){
+    uint64_t state = seed + battle;
+    return Rng::splitmix64(state);
+}
+
+int runBattle(const std::vector<ClassId>& roster, const std::vector<Policy>& policies,
+              uint64_t seed, int& turns){
+    // Characters by value in one block; reserved up front so the pointers stay valid
+    std::vector<AnyCharacter> owned;
+    std::vector<Character *> players;
+    owned.reserve(roster.size());
+    players.reserve(roster.size());
+
+    for(size_t i = 0; i < roster.size(); i++){
+        players.push_back(&emplaceCharacter(owned, roster[i], "P" + std::to_string(i)));
+    }
+
+    // Policies draw from the battle's own generator too, so the seed alone replays the battle
+    Controller controller(players, seed);
+    turns = 0;
+
+    while(!controller.isBattleOver() && turns < SIM_MAX_TURNS){
+        Character *current = controller.getCurrentPlayer();
+        if(current->isAlive()){
+            int action = ATTACK, target = -1;
+            choose(policies[current->getRosterIndex()], players, current, controller.getRng(), action, target);
+            controller.applyAction(current, action, action == AREA_ATTACK ? nullptr : players[target]);
+            turns++;
+        }
+        controller.nextTurn();
+    }
+
+    int winner = -1;
+    int alive = 0;
+    for(size_t i = 0; i < players.size(); i++){
+        if(players[i]->isAlive()){
+            winner = (int)i;
+            alive++;
+        }
+    }
+    return alive == 1 ? winner : -1;
+}
+
+SimulationReport runSimulation(const SimulationConfig& config){
+    int threads = config.threads;
+    if(threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if(threads <= 0) threads = 1;
+    if((uint64_t)threads > config.battles) threads = (int)std::max<uint64_t>(config.battles, 1);
+
+    uint64_t seed = config.seed;
+    if(seed == 0) seed = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+
+    // Every thread fills its own report, merged at the end, so nothing is shared while running
+    std::vector<SimulationReport> partial(threads);
+    std::vector<std::thread> pool;
+    auto start = std::chrono::steady_clock::now();
+
+    // Battle i always gets battleSeed(seed, i), whatever thread runs it
+    uint64_t first = 0;
+    for(int t = 0; t < threads; t++){
+        uint64_t count = config.battles / threads + ((uint64_t)t < config.battles % threads ? 1 : 0);
+
+        pool.emplace_back([&config, &partial, t, first, count, seed](){
+            SimulationReport& report = partial[t];
+            report.wins.assign(config.roster.size(), 0);
+            report.turnCounts.assign(SIM_MAX_TURNS + 1, 0);
+
+            for(uint64_t b = first; b < first + count; b++){
+                int turns;
+                int winner = runBattle(config.roster, config.policies, battleSeed(seed, b), turns);
+                if(winner < 0) report.draws++;
+                else report.wins[winner]++;
+                report.turnCounts[turns]++;
+                report.battles++;
+            }
+        });
+        first += count;
+    }
+    for(auto& th : pool) th.join();
+
+    SimulationReport total;
+    total.seed = seed;
+    total.wins.assign(config.roster.size(), 0);
+    total.turnCounts.assign(SIM_MAX_TURNS + 1, 0);
+    for(const auto& report : partial){
+        total.battles += report.battles;
+        total.draws += report.draws;
+        for(size_t i = 0; i < report.wins.size(); i++) total.wins[i] += report.wins[i];
+        for(size_t i = 0; i < report.turnCounts.size(); i++) total.turnCounts[i] += report.turnCounts[i];
+    }
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total;
+}
+
+// Smallest turn count n such that at least p (0..1) of the battles took n actions or fewer
+uint64_t SimulationReport::turnPercentile(double p) const {
+    uint64_t needed = (uint64_t)(p * battles);
+    if(needed == 0) needed = 1;
+
+    uint64_t seen = 0;
+    for(size_t n = 0; n < turnCounts.size(); n++){
+        seen += turnCounts[n];
+        if(seen >= needed) return n;
+    }
+    return turnCounts.empty() ? 0 : turnCounts.size() - 1;
+}
+
+double SimulationReport::meanTurns() const {
+    if(battles == 0) return 0;
+
+    double sum = 0;
+    for(size_t n = 0; n < turnCounts.size(); n++) sum += (double)n * turnCounts[n];
+    return sum / battles;
+}
@@ -0,0 +1,62 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "characters/factory.h"
+
+// Headless battle simulation: runs complete Controller battles in memory, without sockets or
+// delays, for balance work.
+
+// How a simulated player picks its action and target
+enum Policy {
+    POLICY_RANDOM = 0, // Any action, any living enemy
+    POLICY_ATTACK = 1, // Basic attack on a random living enemy
+    POLICY_FOCUS = 2,  // Special move on the weakest living enemy
+    POLICY_COUNT = 3
+};
+
+// Battles that reach this many actions are counted as draws (e.g. two Mages healing forever)
+#define SIM_MAX_TURNS 10000
+
+struct SimulationConfig {
+    std::vector<ClassId> roster;   // One entry per player, in turn order
+    std::vector<Policy> policies;  // One entry per player
+    uint64_t battles = 1000;
+    int threads = 0;               // 0 = one per core
+    uint64_t seed = 0;             // 0 = seed from the clock
+};
+
+struct SimulationReport {
+    uint64_t seed = 0;  // Base seed actually used
+    uint64_t battles = 0;
+    uint64_t draws = 0;
+    std::vector<uint64_t> wins;        // Per player slot
+    std::vector<uint64_t> turnCounts;  // turnCounts[n] = battles that took n actions
+    double seconds = 0;
+
+    uint64_t turnPercentile(double p) const;
+    double meanTurns() const;
+};
+
+// Parses "3 Orc, 2 Mage, 1 Halfling" into one ClassId per player. Returns false on bad input.
+bool parseRoster(const std::string& text, std::vector<ClassId>& roster, std::string& error);
+
+// Parses "random", "attack" or "focus"
+bool parsePolicy(const std::string& name, Policy& policy);
+const char* policyName(Policy policy);
+
+// Seed of battle number `battle` in a run started with `seed`
+uint64_t battleSeed(uint64_t seed, uint64_t battle);
+
+// Runs one battle; returns the winning slot, or -1 for a draw. turns receives the action count.
+// The same seed always produces the same battle.
+int runBattle(const std::vector<ClassId>& roster, const std::vector<Policy>& policies,
+              uint64_t seed, int& turns);
+
+// Runs config.battles battles spread over config.threads threads
+SimulationReport runSimulation(const SimulationConfig& config);
+
+#endif
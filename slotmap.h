@@ -0,0 +1,107 @@
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Handle of an entry in a SlotMap: the slot's generation in the high 32 bits and its index + 1 in
+// the low ones, so 0 is never a valid handle
+using SlotHandle = uint64_t;
+
+// Entries in reusable slots, addressed by generational handles. Insert, remove and lookup are
+// O(1), and an entry keeps its handle for as long as it lives: removing one never moves the
+// others. A handle to a removed entry stops resolving, even once its slot is reused, so code that
+// holds on to one (a deferred task, a character) can always tell whether the entry is still there.
+// Pointers returned by get stay valid until the next insert.
+template <typename T>
+class SlotMap {
+    private:
+        struct Slot {
+            std::optional<T> value; // Empty when the slot is free
+            uint32_t generation = 0;
+        };
+
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+        size_t count = 0;
+
+        static SlotHandle handleOf(uint32_t index, uint32_t generation){
+            return ((uint64_t)generation << 32) | (index + 1);
+        }
+
+        // Slot a handle refers to if its entry still lives, or nullptr
+        Slot* find(SlotHandle handle){
+            uint32_t index = (uint32_t)handle - 1;
+            if(index >= slots.size()) return nullptr;
+
+            Slot& slot = slots[index];
+            return slot.value && slot.generation == (uint32_t)(handle >> 32) ? &slot : nullptr;
+        }
+
+    public:
+        // Builds a new entry in place and returns its handle
+        template <typename... Args>
+        SlotHandle insert(Args&&... args){
+            uint32_t index;
+            if(!freeSlots.empty()){
+                index = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            else{
+                index = (uint32_t)slots.size();
+                slots.emplace_back();
+            }
+
+            Slot& slot = slots[index];
+            slot.generation++;
+            slot.value.emplace(std::forward<Args>(args)...);
+            count++;
+            return handleOf(index, slot.generation);
+        }
+
+        // Destroys the entry; returns false if it was already gone
+        bool remove(SlotHandle handle){
+            Slot *slot = find(handle);
+            if(!slot) return false;
+
+            slot->value.reset();
+            freeSlots.push_back((uint32_t)(slot - slots.data()));
+            count--;
+            return true;
+        }
+
+        T* get(SlotHandle handle){
+            Slot *slot = find(handle);
+            return slot ? &*slot->value : nullptr;
+        }
+
+        bool contains(SlotHandle handle){ return find(handle) != nullptr; }
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        // Calls f(handle, entry) for every live entry, in slot order. f may remove entries, the one
+        // it was given included, but must not insert.
+        template <typename F>
+        void forEach(F&& f){
+            for(size_t i = 0; i < slots.size(); i++){
+                Slot& slot = slots[i];
+                if(slot.value) f(handleOf((uint32_t)i, slot.generation), *slot.value);
+            }
+        }
+
+        // Handles of every live entry, for walks that may insert or need a stable list
+        std::vector<SlotHandle> handles() const{
+            std::vector<SlotHandle> out;
+            out.reserve(count);
+            for(size_t i = 0; i < slots.size(); i++){
+                if(slots[i].value) out.push_back(handleOf((uint32_t)i, slots[i].generation));
+            }
+            return out;
+        }
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "timerwheel.h"
+
+static const uint64_t SLOT_MASK = TIMER_WHEEL_SLOTS - 1;
+
+// Largest delay the top level can hold without wrapping onto its current slot; longer ones are clamped
+static const uint64_t MAX_DELAY = (uint64_t)(TIMER_WHEEL_SLOTS - 1) << (TIMER_WHEEL_BITS * (TIMER_WHEEL_LEVELS - 1));
+
+TimerWheel::TimerWheel(uint64_t startTick)
+    : slots(TIMER_WHEEL_SLOTS * TIMER_WHEEL_LEVELS, -1), currentTick(startTick), active(0) {}
+
+// Puts a node in the lowest level whose slot range still contains its deadline: the level where
+// the deadline and the current tick only differ in that level's bits
+void TimerWheel::place(int index){
+    Node& node = nodes[index];
+
+    int level = 0;
+    while(level < TIMER_WHEEL_LEVELS - 1 &&
+          (node.expires >> (TIMER_WHEEL_BITS * (level + 1))) != (currentTick >> (TIMER_WHEEL_BITS * (level + 1)))){
+        level++;
+    }
+
+    int slot = level * TIMER_WHEEL_SLOTS + (int)((node.expires >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK);
+    node.slot = slot;
+    node.prev = -1;
+    node.next = slots[slot];
+    if(node.next >= 0) nodes[node.next].prev = index;
+    slots[slot] = index;
+}
+
+void TimerWheel::unlink(int index){
+    Node& node = nodes[index];
+    if(node.prev >= 0) nodes[node.prev].next = node.next;
+    else slots[node.slot] = node.next;
+    if(node.next >= 0) nodes[node.next].prev = node.prev;
+
+    node.prev = node.next = -1;
+    node.slot = -1;
+}
+
+// Redistributes the slot of level that the current tick just entered into the levels below
+void TimerWheel::cascade(int level){
+    int slot = level * TIMER_WHEEL_SLOTS + (int)((currentTick >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK);
+
+    int index = slots[slot];
+    slots[slot] = -1;
+    while(index >= 0){
+        int next = nodes[index].next;
+        place(index);
+        index = next;
+    }
+}
+
+TimeoutId TimerWheel::schedule(uint64_t delayTicks, std::function<void()> callback){
+    if(delayTicks == 0) delayTicks = 1;
+    if(delayTicks > MAX_DELAY) delayTicks = MAX_DELAY;
+
+    int index;
+    if(!freeNodes.empty()){
+        index = freeNodes.back();
+        freeNodes.pop_back();
+    }
+    else{
+        index = (int)nodes.size();
+        nodes.emplace_back();
+    }
+
+    Node& node = nodes[index];
+    node.callback = std::move(callback);
+    node.expires = currentTick + delayTicks;
+    node.generation++;
+    place(index);
+    active++;
+
+    return ((uint64_t)node.generation << 32) | (uint32_t)(index + 1);
+}
+
+bool TimerWheel::cancel(TimeoutId id){
+    int index = (int)(uint32_t)id - 1;
+    uint32_t generation = (uint32_t)(id >> 32);
+    if(index < 0 || index >= (int)nodes.size()) return false;
+
+    Node& node = nodes[index];
+    if(node.slot < 0 || node.generation != generation) return false;
+
+    unlink(index);
+    node.callback = nullptr;
+    freeNodes.push_back(index);
+    active--;
+    return true;
+}
+
+void TimerWheel::advance(uint64_t now){
+    // Nothing to run: jump straight to now instead of walking every idle tick
+    if(active == 0){
+        if(now > currentTick) currentTick = now;
+        return;
+    }
+
+    while(currentTick < now){
+        currentTick++;
+
+        // Entering a new slot of a higher level moves its timers down, highest level first
+        int top = 0;
+        while(top + 1 < TIMER_WHEEL_LEVELS && (currentTick & ((1ull << (TIMER_WHEEL_BITS * (top + 1))) - 1)) == 0) top++;
+        for(int level = top; level >= 1; level--) cascade(level);
+
+        // Runs everything due now. Callbacks may schedule or cancel, so take one node at a time.
+        int slot = (int)(currentTick & SLOT_MASK);
+        while(slots[slot] >= 0){
+            int index = slots[slot];
+            unlink(index);
+
+            std::function<void()> callback = std::move(nodes[index].callback);
+            nodes[index].callback = nullptr;
+            freeNodes.push_back(index);
+            active--;
+
+            callback();
+        }
+
+        if(active == 0){
+            currentTick = now;
+            return;
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Hierarchical timer wheel for large numbers of one-shot deadlines (e.g. one per turn in progress).
+// TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SLOTS slots each: level 0 holds deadlines due within
+// the next 64 ticks, level 1 within the next 64*64, and so on; entries move down a level as their
+// deadline gets closer. Scheduling and cancelling are O(1), and each tick only touches the slots
+// that are due.
+
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+
+// Handle of a scheduled timeout; 0 is never a valid id
+using TimeoutId = uint64_t;
+
+class TimerWheel {
+    private:
+        // Timers live in a slab and are chained per slot through indices
+        struct Node {
+            std::function<void()> callback;
+            uint64_t expires = 0;      // Tick
+            int prev = -1;
+            int next = -1;
+            int slot = -1;             // Index in slots, -1 when free
+            uint32_t generation = 0;   // Bumped on reuse so stale ids are rejected
+        };
+
+        std::vector<Node> nodes;
+        std::vector<int> freeNodes;
+        std::vector<int> slots;  // Head node of every slot, level by level
+        uint64_t currentTick;
+        size_t active;
+
+        void place(int index);
+        void unlink(int index);
+        void cascade(int level);
+
+    public:
+        explicit TimerWheel(uint64_t startTick);
+
+        // Runs callback once the wheel reaches startTick + delayTicks (at least one tick away)
+        TimeoutId schedule(uint64_t delayTicks, std::function<void()> callback);
+
+        // Returns false if the timeout already ran or was cancelled
+        bool cancel(TimeoutId id);
+
+        // Moves the wheel to tick now and runs every callback that became due, in deadline order
+        void advance(uint64_t now);
+
+        uint64_t tick() const { return currentTick; }
+        size_t size() const { return active; }
+        bool empty() const { return active == 0; }
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "acceptor.h"
+#include "worker.h"
+
+Worker::Worker(int id, const ServerConfig& config, JournalSink *journals, Acceptor& acceptor)
+    : id(id), config(config), journals(journals), acceptor(acceptor), lobby(nullptr) {}
+
+Worker::~Worker(){
+    matches.clear();
+}
+
+void Worker::hostLobby(int matchId){
+    reactor.post([this, matchId](){ openLobby(matchId); });
+}
+
+void Worker::takeClients(std::vector<int> socks){
+    reactor.post([this, socks = std::move(socks)](){ addClients(socks); });
+}
+
+// Creates a fresh match in the LOBBY phase that receives the next players. The acceptor is told
+// once it stops taking them, so it opens the next lobby.
+void Worker::openLobby(int matchId){
+    auto onLobbyClosed = [this, matchId](){
+        if(!lobby || lobby->getId() != matchId) return;
+        lobby = nullptr;
+        acceptor.lobbyClosed(this);
+    };
+    auto onFinished = [this, matchId](){
+        matches.erase(matchId);
+        metrics.activeMatches.sub();
+    };
+
+    Match *match = new Match(reactor, matchId, config, metrics, journals, onLobbyClosed, onFinished);
+    matches[matchId] = std::unique_ptr<Match>(match);
+    lobby = match;
+    metrics.activeMatches.add();
+}
+
+// Puts accepted sockets in the open lobby. A full lobby starts its match on the way, and whoever
+// is left goes back to the acceptor for the next lobby.
+void Worker::addClients(const std::vector<int>& socks){
+    std::vector<int> leftover;
+    for(int sock : socks){
+        if(!lobby){
+            leftover.push_back(sock);
+            continue;
+        }
+        metrics.accepted.add();
+        lobby->addClient(sock);
+    }
+
+    if(!leftover.empty()) acceptor.returnClients(std::move(leftover));
+}
+
+void Worker::start(){
+    thread = std::thread([this](){
+        countHeapCalls(&metrics.heapCalls);
+        reactor.run();
+    });
+}
+
+void Worker::join(){
+    if(thread.joinable()) thread.join();
+}
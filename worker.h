@@ -0,0 +1,54 @@
+#ifndef WORKER_H
+#define WORKER_H
+
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "journal.h"
+#include "match.h"
+#include "metrics.h"
+#include "reactor.h"
+#include "serverconfig.h"
+
+class Acceptor;
+
+// One event loop thread hosting any number of matches. The acceptor gives it a lobby to fill
+// now and then and the sockets that join it; from then on the match and its sockets live on this
+// thread only, so matches share no state.
+class Worker {
+    private:
+        int id;
+        const ServerConfig& config;
+        JournalSink *journals; // Shared with every worker; nullptr disables journaling
+        Acceptor& acceptor;
+        Reactor reactor;
+        std::thread thread;
+        WorkerMetrics metrics;
+
+        Match *lobby; // Match currently accepting players, if this worker hosts the open lobby
+        std::unordered_map<int, std::unique_ptr<Match>> matches; // Keyed by match id
+
+        void openLobby(int matchId);
+        void addClients(const std::vector<int>& socks);
+
+    public:
+        Worker(int id, const ServerConfig& config, JournalSink *journals, Acceptor& acceptor);
+        ~Worker();
+
+        Worker(const Worker&) = delete;
+        Worker& operator=(const Worker&) = delete;
+
+        // Called from the acceptor's thread: opens a lobby, or hands it new sockets. Sockets that
+        // arrive after the lobby started its match go back to the acceptor.
+        void hostLobby(int matchId);
+        void takeClients(std::vector<int> socks);
+
+        const WorkerMetrics& getMetrics() const { return metrics; }
+
+        void start();
+        void join();
+};
+
+#endif